@@ -0,0 +1,168 @@
+#ifndef PROTOZERO_BENCH_HPP
+#define PROTOZERO_BENCH_HPP
+
+/*****************************************************************************
+
+Benchmark harness
+
+Shared helpers for the protozero benchmarks: loading input files, timing
+functions and reporting results. Every benchmark function is run once for
+warm-up and then the given number of times. The fastest run is reported.
+
+*****************************************************************************/
+
+#ifdef PROTOZERO_BENCH_USE_ZLIB
+# include <zlib.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace bench {
+
+/// Uncompress gzip compressed data.
+inline std::string gunzip(const std::string& input) {
+#ifdef PROTOZERO_BENCH_USE_ZLIB
+    z_stream stream{};
+    if (inflateInit2(&stream, 16 + MAX_WBITS) != Z_OK) {
+        throw std::runtime_error{"inflateInit2 failed"};
+    }
+
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+    stream.avail_in = static_cast<uInt>(input.size());
+
+    std::string output;
+    int result = Z_OK;
+    while (result == Z_OK) {
+        char chunk[64 * 1024];
+        stream.next_out = reinterpret_cast<Bytef*>(chunk);
+        stream.avail_out = sizeof(chunk);
+        result = inflate(&stream, Z_NO_FLUSH);
+        output.append(chunk, sizeof(chunk) - stream.avail_out);
+    }
+    inflateEnd(&stream);
+
+    if (result != Z_STREAM_END) {
+        throw std::runtime_error{"gzip decompression failed"};
+    }
+
+    return output;
+#else
+    (void)input;
+    throw std::runtime_error{"input is gzip compressed, but benchmarks were built without zlib"};
+#endif
+}
+
+/**
+ * Read the complete contents of a file into a string. Gzip compressed files
+ * (like the ones in bench/data) are uncompressed.
+ */
+inline std::string load_file(const std::string& filename) {
+    std::ifstream stream{filename, std::ios_base::in | std::ios_base::binary};
+    if (!stream) {
+        throw std::runtime_error{"Can not open file '" + filename + "'"};
+    }
+
+    std::string buffer{std::istreambuf_iterator<char>(stream.rdbuf()),
+                       std::istreambuf_iterator<char>()};
+    stream.close();
+
+    if (buffer.size() >= 2 && buffer[0] == '\x1f' && buffer[1] == '\x8b') {
+        return gunzip(buffer);
+    }
+
+    return buffer;
+}
+
+/// Make sure the compiler can not optimize away the computation of value.
+template <typename T>
+inline void do_not_optimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const T* sink;
+    sink = &value;
+#endif
+}
+
+/**
+ * Runs benchmark functions and prints the results.
+ *
+ * Each function must return the number of items (fields, varints, ...) it
+ * processed. The output contains the throughput in MB/s based on the number
+ * of bytes given and the time per item in nanoseconds.
+ */
+class runner {
+
+    std::size_t m_iterations;
+    std::string m_unit;
+
+public:
+
+    runner(std::size_t iterations, std::string unit) :
+        m_iterations(iterations),
+        m_unit(std::move(unit)) {
+    }
+
+    template <typename TFunc>
+    void run(const std::string& name, std::size_t bytes, TFunc&& func) const {
+        using clock = std::chrono::steady_clock;
+
+        std::size_t items = func(); // warm up
+        double best = std::numeric_limits<double>::max();
+
+        for (std::size_t i = 0; i < m_iterations; ++i) {
+            const auto start = clock::now();
+            items = func();
+            const auto stop = clock::now();
+            best = std::min(best, std::chrono::duration<double>(stop - start).count());
+        }
+
+        const double mb_per_s = best > 0 ? static_cast<double>(bytes) / best / (1024.0 * 1024.0) : 0;
+        const double ns_per_item = items > 0 ? best * 1e9 / static_cast<double>(items) : 0;
+
+        std::cout << std::left << std::setw(40) << name << std::right << std::fixed
+                  << std::setw(10) << std::setprecision(1) << mb_per_s << " MB/s"
+                  << std::setw(12) << std::setprecision(2) << ns_per_item << " ns/" << m_unit
+                  << std::setw(12) << items << ' ' << m_unit << "s\n";
+    }
+
+}; // class runner
+
+/**
+ * Parse command line of the form "[-n ITERATIONS] [ARGS...]". Returns the
+ * number of iterations (default_iterations if not set) and fills args with
+ * the remaining arguments.
+ */
+inline std::size_t parse_command_line(int argc, char* argv[], std::size_t default_iterations, std::vector<std::string>& args) {
+    std::size_t iterations = default_iterations;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg{argv[i]};
+        if (arg == "-n" && i + 1 < argc) {
+            iterations = static_cast<std::size_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "-h" || arg == "--help") {
+            std::cout << "Usage: " << argv[0] << " [-n ITERATIONS] [ARGS...]\n";
+            std::exit(0);
+        } else {
+            args.push_back(arg);
+        }
+    }
+
+    return iterations;
+}
+
+} // end namespace bench
+
+#endif // PROTOZERO_BENCH_HPP
@@ -0,0 +1,381 @@
+/*****************************************************************************
+
+Vector tile benchmark
+
+Measures reading and writing of Mapbox vector tiles with protozero.
+
+Usage:
+
+    bench_tile [-n ITERATIONS] [FILENAME...]
+
+If no file names are given, the tiles in bench/data are used.
+
+The vector tile format is described in
+https://github.com/mapbox/vector-tile-spec/blob/master/2.1/vector_tile.proto
+
+*****************************************************************************/
+
+#include "bench.hpp"
+
+#include <protozero/buffer_segmented.hpp>
+#include <protozero/buffer_small.hpp>
+#include <protozero/parallel.hpp>
+#include <protozero/pbf_reader.hpp>
+#include <protozero/pbf_writer.hpp>
+#include <protozero/validate.hpp>
+#include <protozero/vector_tile_geometry.hpp>
+
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Visit all fields of the tile, its layers and their features. Everything
+// else (like the values in a layer) is skipped.
+template <typename TReader>
+std::size_t traverse_tile(const std::string& data) {
+    std::size_t count = 0;
+
+    TReader tile{data};
+    while (tile.next()) {
+        ++count;
+        if (tile.tag() != 3) { // layers
+            tile.skip();
+            continue;
+        }
+        TReader layer{tile.get_message()};
+        while (layer.next()) {
+            ++count;
+            if (layer.tag() != 2) { // features
+                layer.skip();
+                continue;
+            }
+            TReader feature{layer.get_message()};
+            while (feature.next()) {
+                ++count;
+                feature.skip();
+            }
+        }
+    }
+
+    return count;
+}
+
+// Check the tile, its layers, and their features and values.
+bool validate_tile(const std::string& data) {
+    return static_cast<bool>(protozero::validate(data, 2, [](const protozero::pbf_tag_type* path, std::size_t depth) {
+        return path[0] == 3 && (depth == 1 || (depth == 2 && (path[1] == 2 || path[1] == 4)));
+    }));
+}
+
+// Get the names of all layers.
+std::size_t layer_names(const std::string& data) {
+    std::size_t count = 0;
+    std::size_t size = 0;
+
+    protozero::pbf_reader tile{data};
+    while (tile.next(3, protozero::pbf_wire_type::length_delimited)) {
+        protozero::pbf_reader layer{tile.get_message()};
+        while (layer.next(1, protozero::pbf_wire_type::length_delimited)) {
+            size += layer.get_view().size();
+            ++count;
+        }
+    }
+
+    bench::do_not_optimize(size);
+    return count;
+}
+
+// Decode the geometries of all features into absolute coordinates. Returns
+// the number of varints decoded.
+std::size_t decode_geometries(const std::string& data) {
+    std::size_t count = 0;
+    int64_t sum = 0;
+
+    protozero::pbf_reader tile{data};
+    while (tile.next(3, protozero::pbf_wire_type::length_delimited)) {
+        protozero::pbf_reader layer{tile.get_message()};
+        while (layer.next(2, protozero::pbf_wire_type::length_delimited)) {
+            protozero::pbf_reader feature{layer.get_message()};
+            while (feature.next(4, protozero::pbf_wire_type::length_delimited)) {
+                const auto geometry = feature.get_packed_uint32();
+                int32_t x = 0;
+                int32_t y = 0;
+                for (auto it = geometry.begin(); it != geometry.end();) {
+                    const uint32_t command = *it++;
+                    ++count;
+                    const uint32_t id = command & 0x7U;
+                    if (id != 1 && id != 2) { // not MoveTo or LineTo
+                        continue;
+                    }
+                    for (uint32_t n = command >> 3U; n > 0 && it != geometry.end(); --n) {
+                        x += protozero::decode_zigzag32(*it++);
+                        if (it == geometry.end()) {
+                            break;
+                        }
+                        y += protozero::decode_zigzag32(*it++);
+                        count += 2;
+                        sum += x + y;
+                    }
+                }
+            }
+        }
+    }
+
+    bench::do_not_optimize(sum);
+    return count;
+}
+
+// Geometry handler adding up all coordinates. Counts the varints decoded.
+struct sum_handler {
+    std::size_t count = 0;
+    int64_t sum = 0;
+
+    void points(const protozero::geometry_point* points, std::size_t size) {
+        count += 1 + 2 * size;
+        for (std::size_t n = 0; n < size; ++n) {
+            sum += points[n].x + points[n].y;
+        }
+    }
+
+    void move_to(const protozero::geometry_point* begin, std::size_t size) {
+        points(begin, size);
+    }
+
+    void line_to(const protozero::geometry_point* begin, std::size_t size) {
+        points(begin, size);
+    }
+
+    void close_path() {
+        ++count;
+    }
+};
+
+// Same as decode_geometries() using the geometry_decoder.
+std::size_t decode_geometries_with_decoder(const std::string& data, protozero::geometry_decoder& decoder) {
+    sum_handler handler;
+
+    protozero::pbf_reader tile{data};
+    while (tile.next(3, protozero::pbf_wire_type::length_delimited)) {
+        protozero::pbf_reader layer{tile.get_message()};
+        while (layer.next(2, protozero::pbf_wire_type::length_delimited)) {
+            protozero::pbf_reader feature{layer.get_message()};
+            while (feature.next(4, protozero::pbf_wire_type::length_delimited)) {
+                decoder.decode(feature.get_packed_uint32(), handler);
+            }
+        }
+    }
+
+    bench::do_not_optimize(handler.sum);
+    return handler.count;
+}
+
+// Same as decode_geometries_with_decoder() with the layers decoded in
+// parallel.
+std::size_t decode_geometries_parallel(const std::string& data, protozero::thread_pool& pool) {
+    const auto counts = protozero::parallel_decode_submessages(pool, protozero::data_view{data.data(), data.size()}, 3, [](protozero::data_view view) {
+        protozero::geometry_decoder decoder;
+        sum_handler handler;
+        protozero::pbf_reader layer{view};
+        while (layer.next(2, protozero::pbf_wire_type::length_delimited)) {
+            protozero::pbf_reader feature{layer.get_message()};
+            while (feature.next(4, protozero::pbf_wire_type::length_delimited)) {
+                decoder.decode(feature.get_packed_uint32(), handler);
+            }
+        }
+        bench::do_not_optimize(handler.sum);
+        return handler.count;
+    });
+
+    std::size_t count = 0;
+    for (const auto c : counts) {
+        count += c;
+    }
+    return count;
+}
+
+// Copy any field from reader to writer without looking at its contents.
+template <typename TWriter>
+void copy_field(protozero::pbf_reader& reader, TWriter& writer) {
+    const auto tag = reader.tag();
+    switch (reader.wire_type()) {
+        case protozero::pbf_wire_type::varint:
+            writer.add_uint64(tag, reader.get_uint64());
+            break;
+        case protozero::pbf_wire_type::fixed64:
+            writer.add_fixed64(tag, reader.get_fixed64());
+            break;
+        case protozero::pbf_wire_type::length_delimited: {
+            const auto view = reader.get_view();
+            writer.add_bytes(tag, view.data(), view.size());
+            break;
+        }
+        case protozero::pbf_wire_type::fixed32:
+            writer.add_fixed32(tag, reader.get_fixed32());
+            break;
+        default:
+            reader.skip();
+    }
+}
+
+// Read the tile and write it again field by field, decoding and encoding
+// the packed tags and geometries. Returns the number of fields written.
+template <typename TBuffer>
+std::size_t reencode_tile(const std::string& data, TBuffer& out) {
+    using writer_type = protozero::basic_pbf_writer<TBuffer>;
+    std::size_t count = 0;
+
+    out.clear();
+    writer_type tile_writer{out};
+
+    protozero::pbf_reader tile{data};
+    while (tile.next()) {
+        ++count;
+        if (tile.tag() != 3) {
+            copy_field(tile, tile_writer);
+            continue;
+        }
+        protozero::pbf_reader layer{tile.get_message()};
+        writer_type layer_writer{tile_writer, 3};
+        while (layer.next()) {
+            ++count;
+            if (layer.tag() != 2) {
+                copy_field(layer, layer_writer);
+                continue;
+            }
+            protozero::pbf_reader feature{layer.get_message()};
+            writer_type feature_writer{layer_writer, 2};
+            while (feature.next()) {
+                ++count;
+                const auto tag = feature.tag();
+                if (tag == 2 || tag == 4) { // tags, geometry
+                    const auto values = feature.get_packed_uint32();
+                    feature_writer.add_packed_uint32(tag, values.begin(), values.end());
+                } else {
+                    copy_field(feature, feature_writer);
+                }
+            }
+        }
+    }
+
+    return count;
+}
+
+// Write each feature of the tile into its own new buffer, like a program
+// sending many small messages would. Returns the number of fields written.
+template <typename TBuffer>
+std::size_t reencode_features(const std::string& data) {
+    std::size_t count = 0;
+    std::size_t size = 0;
+
+    protozero::pbf_reader tile{data};
+    while (tile.next(3)) {
+        protozero::pbf_reader layer{tile.get_message()};
+        while (layer.next(2)) {
+            TBuffer buffer;
+            protozero::basic_pbf_writer<TBuffer> writer{buffer};
+            protozero::pbf_reader feature{layer.get_message()};
+            while (feature.next()) {
+                ++count;
+                copy_field(feature, writer);
+            }
+            size += buffer.size();
+        }
+    }
+
+    bench::do_not_optimize(size);
+    return count;
+}
+
+} // anonymous namespace
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> filenames;
+    const auto iterations = bench::parse_command_line(argc, argv, 100, filenames);
+
+    if (filenames.empty()) {
+        filenames.emplace_back(PROTOZERO_BENCH_DATA_DIR "/mapbox-streets-v6-14-8714-8017.vector.pbf");
+        filenames.emplace_back(PROTOZERO_BENCH_DATA_DIR "/enf-14-4824-6157.vector.pbf");
+    }
+
+    const bench::runner runner{iterations, "field"};
+    protozero::thread_pool pool;
+
+    try {
+        for (const auto& filename : filenames) {
+            const std::string data = bench::load_file(filename);
+            std::cout << filename << " (" << data.size() << " bytes)\n";
+
+            runner.run("  traverse tile with next()/skip()", data.size(), [&]() {
+                return traverse_tile<protozero::pbf_reader>(data);
+            });
+
+            if (!validate_tile(data)) {
+                std::cerr << "tile is invalid\n";
+                return 1;
+            }
+
+            runner.run("  validate, then traverse (trusted)", data.size(), [&]() {
+                bench::do_not_optimize(validate_tile(data));
+                return traverse_tile<protozero::trusted_pbf_reader>(data);
+            });
+
+            runner.run("  traverse tile (trusted_pbf_reader)", data.size(), [&]() {
+                return traverse_tile<protozero::trusted_pbf_reader>(data);
+            });
+
+            runner.run("  get layer names", data.size(), [&]() {
+                return layer_names(data);
+            });
+
+            runner.run("  decode geometries", data.size(), [&]() {
+                return decode_geometries(data);
+            });
+
+            protozero::geometry_decoder decoder;
+            runner.run("  decode geometries (geometry_decoder)", data.size(), [&]() {
+                return decode_geometries_with_decoder(data, decoder);
+            });
+
+            runner.run("  decode geometries (parallel layers)", data.size(), [&]() {
+                return decode_geometries_parallel(data, pool);
+            });
+
+            std::string out;
+            runner.run("  re-encode tile", data.size(), [&]() {
+                return reencode_tile(data, out);
+            });
+
+            if (out != data) {
+                std::cerr << "re-encoded tile differs from input\n";
+                return 1;
+            }
+
+            protozero::segmented_buffer segmented{64UL * 1024UL};
+            runner.run("  re-encode tile (segmented_buffer)", data.size(), [&]() {
+                return reencode_tile(data, segmented);
+            });
+
+            if (segmented.flatten() != data) {
+                std::cerr << "re-encoded tile differs from input\n";
+                return 1;
+            }
+
+            runner.run("  re-encode features (std::string)", data.size(), [&]() {
+                return reencode_features<std::string>(data);
+            });
+
+            runner.run("  re-encode features (small_buffer)", data.size(), [&]() {
+                return reencode_features<protozero::small_buffer<256>>(data);
+            });
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << '\n';
+        return 1;
+    }
+
+    return 0;
+}
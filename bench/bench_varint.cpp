@@ -0,0 +1,294 @@
+/*****************************************************************************
+
+Varint benchmark
+
+Measures the low-level varint functions decode_varint(), skip_varint(),
+write_varint() and length_of_varint() on different distributions of values
+and writing each value as a field with pbf_writer::add_uint64() with the
+tag given at runtime and at compile time.
+Also compares decoding all varints into a new std::vector from the
+iterators of the range and with decode_packed_into(), decoding
+zigzag-encoded deltas into absolute values with a loop over the varints
+and with decode_packed_svarint_delta(), and writing
+all values as a packed repeated field element by element and with
+add_packed_uint64().
+
+Decoding and skipping is measured twice: Once with the whole buffer
+available (so there are always at least max_varint_length bytes left and
+the fast path is used) and once with each varint being the last thing in
+the buffer (like the last field of a message) which uses the slow path for
+varints longer than one byte.
+
+Usage:
+
+    bench_varint [-n ITERATIONS] [NUMBER_OF_VALUES]
+
+*****************************************************************************/
+
+#include "bench.hpp"
+
+#include <protozero/bulk_varint.hpp>
+#include <protozero/pbf_writer.hpp>
+#include <protozero/varint.hpp>
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct distribution {
+    std::string name;
+    std::vector<uint64_t> values;
+};
+
+std::vector<distribution> create_distributions(std::size_t count) {
+    std::mt19937_64 rng{42}; // fixed seed so all runs use the same data
+    std::vector<distribution> distributions;
+
+    // Values that always fit into one byte.
+    {
+        std::uniform_int_distribution<uint64_t> dist{0, 127};
+        distribution d{"1 byte", {}};
+        for (std::size_t i = 0; i < count; ++i) {
+            d.values.push_back(dist(rng));
+        }
+        distributions.push_back(std::move(d));
+    }
+
+    // Varints with a length uniformly distributed between 1 and 10 bytes.
+    {
+        std::uniform_int_distribution<unsigned int> length{1, 10};
+        distribution d{"uniform 1-10 bytes", {}};
+        for (std::size_t i = 0; i < count; ++i) {
+            const unsigned int bits = length(rng) * 7;
+            const uint64_t value = rng();
+            d.values.push_back(bits >= 64 ? (value | (1ULL << 63U)) : (value >> (64U - bits)));
+        }
+        distributions.push_back(std::move(d));
+    }
+
+    // Zigzag encoded small deltas like those used for coordinates.
+    {
+        std::normal_distribution<double> dist{0.0, 200.0};
+        distribution d{"zigzag deltas", {}};
+        for (std::size_t i = 0; i < count; ++i) {
+            d.values.push_back(protozero::encode_zigzag64(static_cast<int64_t>(dist(rng))));
+        }
+        distributions.push_back(std::move(d));
+    }
+
+    // Keys of fields (tag and wire type), mostly small tags, some large.
+    {
+        std::uniform_int_distribution<uint32_t> small_tag{1, 15};
+        std::uniform_int_distribution<uint32_t> large_tag{16, (1U << 29U) - 1};
+        std::uniform_int_distribution<uint32_t> type{0, 5};
+        std::uniform_int_distribution<int> choice{0, 9};
+        distribution d{"32 bit tags", {}};
+        for (std::size_t i = 0; i < count; ++i) {
+            const uint32_t tag = choice(rng) < 8 ? small_tag(rng) : large_tag(rng);
+            d.values.push_back((static_cast<uint64_t>(tag) << 3U) | type(rng));
+        }
+        distributions.push_back(std::move(d));
+    }
+
+    return distributions;
+}
+
+void run_benchmarks(const bench::runner& runner, const distribution& dist) {
+    // Encode all values into one buffer and remember where each starts.
+    std::string buffer;
+    std::vector<std::size_t> offsets;
+    for (const auto value : dist.values) {
+        offsets.push_back(buffer.size());
+        char tmp[protozero::max_varint_length];
+        buffer.append(tmp, static_cast<std::size_t>(protozero::write_varint(tmp, value)));
+    }
+    offsets.push_back(buffer.size());
+
+    // Padding so that the last varints also use the fast path.
+    const std::size_t size = buffer.size();
+    buffer.append(protozero::max_varint_length, '\0');
+
+    const char* const begin = buffer.data();
+    const std::size_t count = dist.values.size();
+
+    std::cout << dist.name << " (" << count << " varints, " << size << " bytes)\n";
+
+    runner.run("  decode_varint (fast path)", size, [&]() {
+        const char* p = begin;
+        const char* const end = begin + buffer.size();
+        uint64_t sum = 0;
+        for (std::size_t i = 0; i < count; ++i) {
+            sum += protozero::decode_varint(&p, end);
+        }
+        bench::do_not_optimize(sum);
+        return count;
+    });
+
+    runner.run("  decode_varint (tail path)", size, [&]() {
+        uint64_t sum = 0;
+        for (std::size_t i = 0; i < count; ++i) {
+            const char* p = begin + offsets[i];
+            sum += protozero::decode_varint(&p, begin + offsets[i + 1]);
+        }
+        bench::do_not_optimize(sum);
+        return count;
+    });
+
+    runner.run("  skip_varint (fast path)", size, [&]() {
+        const char* p = begin;
+        const char* const end = begin + buffer.size();
+        for (std::size_t i = 0; i < count; ++i) {
+            protozero::skip_varint(&p, end);
+        }
+        bench::do_not_optimize(p);
+        return count;
+    });
+
+    runner.run("  skip_varint (tail path)", size, [&]() {
+        std::size_t sum = 0;
+        for (std::size_t i = 0; i < count; ++i) {
+            const char* p = begin + offsets[i];
+            protozero::skip_varint(&p, begin + offsets[i + 1]);
+            sum += static_cast<std::size_t>(p - begin);
+        }
+        bench::do_not_optimize(sum);
+        return count;
+    });
+
+    std::string out(count * protozero::max_varint_length, '\0');
+    runner.run("  write_varint", size, [&]() {
+        char* p = &out[0];
+        for (const auto value : dist.values) {
+            p += protozero::write_varint(p, value);
+        }
+        bench::do_not_optimize(p);
+        return count;
+    });
+
+    if (out.compare(0, size, buffer, 0, size) != 0) {
+        std::cerr << "write_varint created different data\n";
+        std::exit(1);
+    }
+
+    std::string fields;
+    runner.run("  add_uint64 (pbf_writer)", size, [&]() {
+        fields.clear();
+        protozero::pbf_writer writer{fields};
+        for (const auto value : dist.values) {
+            writer.add_uint64(1, value);
+        }
+        return count;
+    });
+
+    runner.run("  add_uint64<1> (pbf_writer)", size, [&]() {
+        fields.clear();
+        protozero::pbf_writer writer{fields};
+        for (const auto value : dist.values) {
+            writer.add_uint64<1>(value);
+        }
+        return count;
+    });
+
+    const protozero::iterator_range<protozero::const_varint_iterator<uint64_t>> range{
+        protozero::const_varint_iterator<uint64_t>{begin, begin + size},
+        protozero::const_varint_iterator<uint64_t>{begin + size, begin + size}};
+
+    runner.run("  packed decode (vector from iterators)", size, [&]() {
+        const std::vector<uint64_t> values(range.begin(), range.end());
+        bench::do_not_optimize(values.data());
+        return count;
+    });
+
+    runner.run("  packed decode (decode_packed_into)", size, [&]() {
+        std::vector<uint64_t> values;
+        protozero::decode_packed_into(range, values);
+        bench::do_not_optimize(values.data());
+        return count;
+    });
+
+    std::vector<int64_t> sums(count);
+    runner.run("  delta decode (loop)", size, [&]() {
+        const char* p = begin;
+        const char* const end = begin + size;
+        int64_t* o = sums.data();
+        uint64_t sum = 0;
+        while (p != end) {
+            sum += static_cast<uint64_t>(protozero::decode_zigzag64(protozero::decode_varint(&p, end)));
+            *o++ = static_cast<int64_t>(sum);
+        }
+        bench::do_not_optimize(o);
+        return count;
+    });
+
+    runner.run("  delta decode (bulk)", size, [&]() {
+        const char* p = begin;
+        auto* o = protozero::decode_packed_svarint_delta(&p, begin + size, sums.data());
+        bench::do_not_optimize(o);
+        return count;
+    });
+
+    std::vector<int32_t> sums32(count);
+    runner.run("  delta decode int32 (bulk)", size, [&]() {
+        const char* p = begin;
+        auto* o = protozero::decode_packed_svarint_delta(&p, begin + size, sums32.data());
+        bench::do_not_optimize(o);
+        return count;
+    });
+
+    std::string packed;
+    runner.run("  packed write (packed_field)", size, [&]() {
+        packed.clear();
+        protozero::pbf_writer writer{packed};
+        protozero::packed_field_uint64 field{writer, 1};
+        for (const auto value : dist.values) {
+            field.add_element(value);
+        }
+        return count;
+    });
+
+    runner.run("  packed write (add_packed_uint64)", size, [&]() {
+        packed.clear();
+        protozero::pbf_writer writer{packed};
+        writer.add_packed_uint64(1, dist.values.begin(), dist.values.end());
+        return count;
+    });
+
+    if (packed.compare(packed.size() - size, size, buffer, 0, size) != 0) {
+        std::cerr << "add_packed_uint64 created different data\n";
+        std::exit(1);
+    }
+
+    runner.run("  length_of_varint", size, [&]() {
+        std::size_t sum = 0;
+        for (const auto value : dist.values) {
+            sum += static_cast<std::size_t>(protozero::length_of_varint(value));
+        }
+        bench::do_not_optimize(sum);
+        return count;
+    });
+}
+
+} // anonymous namespace
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> args;
+    const auto iterations = bench::parse_command_line(argc, argv, 20, args);
+
+    std::size_t count = 1000000;
+    if (!args.empty()) {
+        count = static_cast<std::size_t>(std::strtoul(args[0].c_str(), nullptr, 10));
+    }
+
+    const bench::runner runner{iterations, "varint"};
+
+    for (const auto& dist : create_distributions(count)) {
+        run_benchmarks(runner, dist);
+    }
+
+    return 0;
+}
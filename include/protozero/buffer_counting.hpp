@@ -0,0 +1,123 @@
+#ifndef PROTOZERO_BUFFER_COUNTING_HPP
+#define PROTOZERO_BUFFER_COUNTING_HPP
+
+/*****************************************************************************
+
+protozero - Minimalistic protocol buffer decoder and encoder in C++.
+
+This file is from https://github.com/mapbox/protozero where you can find more
+documentation.
+
+*****************************************************************************/
+
+/**
+ * @file buffer_counting.hpp
+ *
+ * @brief Contains the counting_buffer class.
+ */
+
+#include <protozero/buffer_tmpl.hpp>
+#include <protozero/config.hpp>
+#include <protozero/varint.hpp>
+
+#include <cstddef>
+
+namespace protozero {
+
+/**
+ * A buffer that doesn't store any data, it only keeps track of how many
+ * bytes have been written into it. Use it with a basic_pbf_writer to find
+ * out how large a message will be without creating it. Together with
+ * submessage_sizes this is the first pass of writing a message in two passes.
+ */
+class counting_buffer {
+
+    std::size_t m_size = 0;
+
+    // Space for writing the length of submessages into.
+    char m_scratch[max_varint_length] = {};
+
+public:
+
+    /// The number of bytes written into the buffer.
+    std::size_t size() const noexcept {
+        return m_size;
+    }
+
+    /// Reset the size to 0.
+    void clear() noexcept {
+        m_size = 0;
+    }
+
+/// @cond INTERNAL
+
+    // Do not rely on anything beyond this point
+
+    void add(std::size_t count) noexcept {
+        m_size += count;
+    }
+
+    void resize(std::size_t size) {
+        protozero_assert(size <= m_size);
+        m_size = size;
+    }
+
+    void erase_range(std::size_t from, std::size_t to) {
+        protozero_assert(from <= m_size);
+        protozero_assert(to <= m_size);
+        protozero_assert(from <= to);
+        m_size -= (to - from);
+    }
+
+    char* scratch() noexcept {
+        return m_scratch;
+    }
+
+/// @endcond
+
+}; // class counting_buffer
+
+/// @cond INTERNAL
+template <>
+struct buffer_customization<counting_buffer> {
+
+    static std::size_t size(const counting_buffer* buffer) noexcept {
+        return buffer->size();
+    }
+
+    static void append(counting_buffer* buffer, const char* /*data*/, std::size_t count) noexcept {
+        buffer->add(count);
+    }
+
+    static void append_zeros(counting_buffer* buffer, std::size_t count) noexcept {
+        buffer->add(count);
+    }
+
+    static void resize(counting_buffer* buffer, std::size_t size) {
+        buffer->resize(size);
+    }
+
+    static void reserve_additional(counting_buffer* /*buffer*/, std::size_t /*size*/) noexcept {
+        /* nothing to be done for counting buffers */
+    }
+
+    static void erase_range(counting_buffer* buffer, std::size_t from, std::size_t to) {
+        buffer->erase_range(from, to);
+    }
+
+    // The writer only uses this to write the length of a submessage, which
+    // nobody will look at.
+    static char* at_pos(counting_buffer* buffer, std::size_t /*pos*/) noexcept {
+        return buffer->scratch();
+    }
+
+    static void push_back(counting_buffer* buffer, char /*ch*/) noexcept {
+        buffer->add(1);
+    }
+
+};
+/// @endcond
+
+} // end namespace protozero
+
+#endif // PROTOZERO_BUFFER_COUNTING_HPP
@@ -0,0 +1,351 @@
+#ifndef PROTOZERO_BUFFER_SEGMENTED_HPP
+#define PROTOZERO_BUFFER_SEGMENTED_HPP
+
+/*****************************************************************************
+
+protozero - Minimalistic protocol buffer decoder and encoder in C++.
+
+This file is from https://github.com/mapbox/protozero where you can find more
+documentation.
+
+*****************************************************************************/
+
+/**
+ * @file buffer_segmented.hpp
+ *
+ * @brief Contains the segmented_buffer class.
+ */
+
+#include <protozero/buffer_tmpl.hpp>
+#include <protozero/config.hpp>
+#include <protozero/data_view.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+# include <sys/uio.h>
+#endif
+
+namespace protozero {
+
+/**
+ * A buffer for very large messages. The data is stored in a list of
+ * segments which are allocated as needed, so the data already written
+ * never has to be copied to a larger buffer when the buffer grows. Unlike
+ * with a std::string there is no point in time where the old and the new
+ * memory of the buffer are needed at the same time.
+ *
+ * Use the segments directly (for instance with `writev()`) or copy them
+ * into one string at the end:
+ *
+ * @code
+ *    protozero::segmented_buffer buffer;
+ *    protozero::basic_pbf_writer<protozero::segmented_buffer> writer{buffer};
+ *    ...
+ *    const auto iov = buffer.iovecs();
+ *    writev(fd, iov.data(), static_cast<int>(iov.size()));
+ * @endcode
+ *
+ * When a submessage is closed, the writer has to remove the unused bytes
+ * reserved for its length. In a std::string this moves all data of the
+ * submessage, here only the data after it in the same segment is moved.
+ */
+class segmented_buffer {
+
+    struct segment {
+        std::unique_ptr<char[]> data;
+        std::size_t capacity;
+        std::size_t size;
+    };
+
+    // All segments allocated. Only the first m_used ones contain data, the
+    // others are kept for reuse after clear() or resize().
+    std::vector<segment> m_segments;
+    std::size_t m_used = 0;
+
+    // Total number of bytes in all segments.
+    std::size_t m_size = 0;
+
+    std::size_t m_segment_size;
+
+    segment& current() {
+        protozero_assert(m_used > 0);
+        return m_segments[m_used - 1];
+    }
+
+    std::size_t available() const noexcept {
+        if (m_used == 0) {
+            return 0;
+        }
+        const auto& seg = m_segments[m_used - 1];
+        return seg.capacity - seg.size;
+    }
+
+    // Start a new segment with space for at least count bytes.
+    void next_segment(std::size_t count) {
+        if (m_used < m_segments.size() && m_segments[m_used].capacity >= count) {
+            ++m_used;
+            return;
+        }
+        const std::size_t capacity = std::max(m_segment_size, count);
+        segment seg{std::unique_ptr<char[]>{new char[capacity]}, capacity, 0};
+        m_segments.insert(m_segments.begin() + static_cast<std::ptrdiff_t>(m_used), std::move(seg));
+        ++m_used;
+    }
+
+    // Find the segment containing the byte at pos. Returns the index of the
+    // segment and sets *offset to the offset of pos in that segment. A pos
+    // at the boundary between segments maps to offset 0 of the last segment
+    // starting there, not to the end of the segment before it. at_pos() and
+    // erase_range() rely on this. Submessages are usually closed near the
+    // end of the data, so the search starts there.
+    std::size_t find(std::size_t pos, std::size_t* offset) const {
+        protozero_assert(pos <= m_size);
+        std::size_t start = m_size;
+        std::size_t n = m_used;
+        while (n > 0) {
+            --n;
+            start -= m_segments[n].size;
+            if (start <= pos) {
+                break;
+            }
+        }
+        *offset = pos - start;
+        return n;
+    }
+
+public:
+
+    /// The default size of the segments: 1 MiB.
+    enum constant_default_segment_size : std::size_t {
+        default_segment_size = 1024UL * 1024UL
+    };
+
+    /**
+     * Create an empty buffer.
+     *
+     * @param segment_size The number of bytes in each segment. Large
+     *        fields are split across segments, so segments are never
+     *        larger than this. Must be at least 16.
+     */
+    explicit segmented_buffer(std::size_t segment_size = default_segment_size) :
+        m_segment_size(segment_size) {
+        protozero_assert(segment_size >= 16);
+    }
+
+    /// The number of bytes in the buffer.
+    std::size_t size() const noexcept {
+        return m_size;
+    }
+
+    /// Is the buffer empty?
+    bool empty() const noexcept {
+        return m_size == 0;
+    }
+
+    /// The number of bytes in each segment.
+    std::size_t segment_size() const noexcept {
+        return m_segment_size;
+    }
+
+    /// The number of segments containing data.
+    std::size_t num_segments() const noexcept {
+        return m_used;
+    }
+
+    /**
+     * Remove all data from the buffer. The segments are kept and reused
+     * for new data.
+     */
+    void clear() noexcept {
+        for (std::size_t n = 0; n < m_used; ++n) {
+            m_segments[n].size = 0;
+        }
+        m_used = 0;
+        m_size = 0;
+    }
+
+    /**
+     * Get the data in all segments in order. Empty segments are left out.
+     * The views are valid until data is added or removed.
+     */
+    std::vector<data_view> segments() const {
+        std::vector<data_view> result;
+        result.reserve(m_used);
+        for (std::size_t n = 0; n < m_used; ++n) {
+            if (m_segments[n].size > 0) {
+                result.emplace_back(m_segments[n].data.get(), m_segments[n].size);
+            }
+        }
+        return result;
+    }
+
+#ifndef _WIN32
+    /**
+     * Get the data in all segments in order as iovec structs as used by the
+     * `writev()` system call. Empty segments are left out. The pointers are
+     * valid until data is added or removed. Not available on Windows.
+     *
+     * Note that `writev()` only accepts a limited number of iovecs
+     * (`IOV_MAX`, often 1024) in one call and might write less data than
+     * requested.
+     */
+    std::vector<iovec> iovecs() const {
+        std::vector<iovec> result;
+        result.reserve(m_used);
+        for (std::size_t n = 0; n < m_used; ++n) {
+            if (m_segments[n].size > 0) {
+                iovec iov{};
+                iov.iov_base = m_segments[n].data.get();
+                iov.iov_len = m_segments[n].size;
+                result.push_back(iov);
+            }
+        }
+        return result;
+    }
+#endif
+
+    /**
+     * Copy all data into one string. This allocates memory for the whole
+     * data once.
+     */
+    std::string flatten() const {
+        std::string result;
+        result.reserve(m_size);
+        for (std::size_t n = 0; n < m_used; ++n) {
+            result.append(m_segments[n].data.get(), m_segments[n].size);
+        }
+        return result;
+    }
+
+/// @cond INTERNAL
+
+    // Do not rely on anything beyond this point
+
+    void append(const char* data, std::size_t count) {
+        while (count > 0) {
+            if (available() == 0) {
+                next_segment(0);
+            }
+            auto& seg = current();
+            const auto n = std::min(count, seg.capacity - seg.size);
+            std::copy_n(data, n, seg.data.get() + seg.size);
+            seg.size += n;
+            m_size += n;
+            data += n;
+            count -= n;
+        }
+    }
+
+    // The zeros are always kept in one segment, because the writer uses
+    // them for the length of a submessage and writes it through at_pos().
+    void append_zeros(std::size_t count) {
+        if (count == 0) {
+            return;
+        }
+        if (available() < count) {
+            next_segment(count);
+        }
+        auto& seg = current();
+        std::fill_n(seg.data.get() + seg.size, count, '\0');
+        seg.size += count;
+        m_size += count;
+    }
+
+    void resize(std::size_t size) {
+        protozero_assert(size <= m_size);
+        if (m_used == 0) {
+            return;
+        }
+        while (m_used > 1 && m_size - current().size >= size) {
+            m_size -= current().size;
+            current().size = 0;
+            --m_used;
+        }
+        current().size -= m_size - size;
+        m_size = size;
+    }
+
+    void erase_range(std::size_t from, std::size_t to) {
+        protozero_assert(from <= m_size);
+        protozero_assert(to <= m_size);
+        protozero_assert(from <= to);
+        if (from == to) {
+            return;
+        }
+        std::size_t offset = 0;
+        const auto n = find(from, &offset);
+        auto& seg = m_segments[n];
+        // The writer only erases bytes from the length of a submessage
+        // which is always in one segment.
+        protozero_assert(offset + (to - from) <= seg.size);
+        char* const begin = seg.data.get();
+        std::copy(begin + offset + (to - from), begin + seg.size, begin + offset);
+        seg.size -= to - from;
+        m_size -= to - from;
+    }
+
+    char* at_pos(std::size_t pos) {
+        std::size_t offset = 0;
+        const auto n = find(pos, &offset);
+        return m_segments[n].data.get() + offset;
+    }
+
+    void push_back(char ch) {
+        if (available() == 0) {
+            next_segment(0);
+        }
+        auto& seg = current();
+        seg.data[seg.size++] = ch;
+        ++m_size;
+    }
+/// @endcond
+
+}; // class segmented_buffer
+
+/// @cond INTERNAL
+template <>
+struct buffer_customization<segmented_buffer> {
+
+    static std::size_t size(const segmented_buffer* buffer) noexcept {
+        return buffer->size();
+    }
+
+    static void append(segmented_buffer* buffer, const char* data, std::size_t count) {
+        buffer->append(data, count);
+    }
+
+    static void append_zeros(segmented_buffer* buffer, std::size_t count) {
+        buffer->append_zeros(count);
+    }
+
+    static void resize(segmented_buffer* buffer, std::size_t size) {
+        buffer->resize(size);
+    }
+
+    static void reserve_additional(segmented_buffer* /*buffer*/, std::size_t /*size*/) noexcept {
+        /* nothing to be done, segments are allocated as needed */
+    }
+
+    static void erase_range(segmented_buffer* buffer, std::size_t from, std::size_t to) {
+        buffer->erase_range(from, to);
+    }
+
+    static char* at_pos(segmented_buffer* buffer, std::size_t pos) {
+        return buffer->at_pos(pos);
+    }
+
+    static void push_back(segmented_buffer* buffer, char ch) {
+        buffer->push_back(ch);
+    }
+
+};
+/// @endcond
+
+} // end namespace protozero
+
+#endif // PROTOZERO_BUFFER_SEGMENTED_HPP
@@ -0,0 +1,269 @@
+#ifndef PROTOZERO_BUFFER_SMALL_HPP
+#define PROTOZERO_BUFFER_SMALL_HPP
+
+/*****************************************************************************
+
+protozero - Minimalistic protocol buffer decoder and encoder in C++.
+
+This file is from https://github.com/mapbox/protozero where you can find more
+documentation.
+
+*****************************************************************************/
+
+/**
+ * @file buffer_small.hpp
+ *
+ * @brief Contains the small_buffer class template.
+ */
+
+#include <protozero/buffer_tmpl.hpp>
+#include <protozero/config.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <string>
+
+namespace protozero {
+
+/**
+ * A buffer with space for N bytes inside the object itself. If more space
+ * is needed, the data is moved to memory allocated on the heap. Use it on
+ * the stack for writing small messages without any memory allocation in
+ * the common case:
+ *
+ * @code
+ *    protozero::small_buffer<256> buffer;
+ *    protozero::basic_pbf_writer<protozero::small_buffer<256>> writer{buffer};
+ *    ...
+ *    send(buffer.data(), buffer.size());
+ * @endcode
+ *
+ * Objects of this class can't be copied or moved, because the writer keeps
+ * a pointer to the buffer. If you need a buffer which never allocates and
+ * fails instead, use the fixed_size_buffer_adaptor.
+ *
+ * @tparam N Number of bytes available without allocating memory.
+ */
+template <std::size_t N>
+class small_buffer {
+
+    static_assert(N > 0, "small_buffer needs at least one byte of inline storage");
+
+    char m_inline[N];
+    std::unique_ptr<char[]> m_heap;
+    char* m_data = m_inline;
+    std::size_t m_capacity = N;
+    std::size_t m_size = 0;
+
+    // Make room for at least count more bytes. The capacity is at least
+    // doubled, so that appending is amortized constant time.
+    void grow(std::size_t count) {
+        const std::size_t capacity = std::max(m_capacity * 2, m_size + count);
+        std::unique_ptr<char[]> heap{new char[capacity]};
+        std::copy_n(m_data, m_size, heap.get());
+        m_heap = std::move(heap);
+        m_data = m_heap.get();
+        m_capacity = capacity;
+    }
+
+public:
+
+    /// @cond usual container typedefs not documented
+
+    using size_type = std::size_t;
+
+    using value_type = char;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using pointer = value_type*;
+    using const_pointer = const value_type*;
+
+    using iterator = pointer;
+    using const_iterator = const_pointer;
+
+    /// @endcond
+
+    /// Create an empty buffer.
+    small_buffer() noexcept = default;
+
+    small_buffer(const small_buffer&) = delete;
+    small_buffer& operator=(const small_buffer&) = delete;
+
+    small_buffer(small_buffer&&) = delete;
+    small_buffer& operator=(small_buffer&&) = delete;
+
+    ~small_buffer() = default;
+
+    /// Returns a pointer to the data in the buffer.
+    const char* data() const noexcept {
+        return m_data;
+    }
+
+    /// Returns a pointer to the data in the buffer.
+    char* data() noexcept {
+        return m_data;
+    }
+
+    /// The number of bytes used in the buffer.
+    std::size_t size() const noexcept {
+        return m_size;
+    }
+
+    /// Is the buffer empty?
+    bool empty() const noexcept {
+        return m_size == 0;
+    }
+
+    /**
+     * The number of bytes that fit into the buffer without allocating
+     * (more) memory.
+     */
+    std::size_t capacity() const noexcept {
+        return m_capacity;
+    }
+
+    /// Has the data outgrown the space inside the object?
+    bool on_heap() const noexcept {
+        return m_data != m_inline;
+    }
+
+    /**
+     * Remove all data from the buffer. Memory allocated on the heap is
+     * kept, so the buffer can be reused without allocating again.
+     */
+    void clear() noexcept {
+        m_size = 0;
+    }
+
+    /// Return the data as std::string.
+    std::string to_string() const {
+        return std::string(m_data, m_size);
+    }
+
+    /// Return iterator to beginning of data.
+    char* begin() noexcept {
+        return m_data;
+    }
+
+    /// Return iterator to beginning of data.
+    const char* begin() const noexcept {
+        return m_data;
+    }
+
+    /// Return iterator to beginning of data.
+    const char* cbegin() const noexcept {
+        return m_data;
+    }
+
+    /// Return iterator to end of data.
+    char* end() noexcept {
+        return m_data + m_size;
+    }
+
+    /// Return iterator to end of data.
+    const char* end() const noexcept {
+        return m_data + m_size;
+    }
+
+    /// Return iterator to end of data.
+    const char* cend() const noexcept {
+        return m_data + m_size;
+    }
+
+/// @cond INTERNAL
+
+    // Do not rely on anything beyond this point
+
+    void append(const char* data, std::size_t count) {
+        if (count > m_capacity - m_size) {
+            grow(count);
+        }
+        std::copy_n(data, count, m_data + m_size);
+        m_size += count;
+    }
+
+    void append_zeros(std::size_t count) {
+        if (count > m_capacity - m_size) {
+            grow(count);
+        }
+        std::fill_n(m_data + m_size, count, '\0');
+        m_size += count;
+    }
+
+    void resize(std::size_t size) {
+        protozero_assert(size <= m_size);
+        m_size = size;
+    }
+
+    void reserve_additional(std::size_t size) {
+        if (size > m_capacity - m_size) {
+            grow(size);
+        }
+    }
+
+    void erase_range(std::size_t from, std::size_t to) {
+        protozero_assert(from <= m_size);
+        protozero_assert(to <= m_size);
+        protozero_assert(from <= to);
+        std::copy(m_data + to, m_data + m_size, m_data + from);
+        m_size -= (to - from);
+    }
+
+    char* at_pos(std::size_t pos) {
+        protozero_assert(pos <= m_size);
+        return m_data + pos;
+    }
+
+    void push_back(char ch) {
+        if (m_size == m_capacity) {
+            grow(1);
+        }
+        m_data[m_size++] = ch;
+    }
+/// @endcond
+
+}; // class small_buffer
+
+/// @cond INTERNAL
+template <std::size_t N>
+struct buffer_customization<small_buffer<N>> {
+
+    static std::size_t size(const small_buffer<N>* buffer) noexcept {
+        return buffer->size();
+    }
+
+    static void append(small_buffer<N>* buffer, const char* data, std::size_t count) {
+        buffer->append(data, count);
+    }
+
+    static void append_zeros(small_buffer<N>* buffer, std::size_t count) {
+        buffer->append_zeros(count);
+    }
+
+    static void resize(small_buffer<N>* buffer, std::size_t size) {
+        buffer->resize(size);
+    }
+
+    static void reserve_additional(small_buffer<N>* buffer, std::size_t size) {
+        buffer->reserve_additional(size);
+    }
+
+    static void erase_range(small_buffer<N>* buffer, std::size_t from, std::size_t to) {
+        buffer->erase_range(from, to);
+    }
+
+    static char* at_pos(small_buffer<N>* buffer, std::size_t pos) {
+        return buffer->at_pos(pos);
+    }
+
+    static void push_back(small_buffer<N>* buffer, char ch) {
+        buffer->push_back(ch);
+    }
+
+};
+/// @endcond
+
+} // end namespace protozero
+
+#endif // PROTOZERO_BUFFER_SMALL_HPP
@@ -0,0 +1,95 @@
+#ifndef PROTOZERO_BUFFER_TMPL_HPP
+#define PROTOZERO_BUFFER_TMPL_HPP
+
+/*****************************************************************************
+
+protozero - Minimalistic protocol buffer decoder and encoder in C++.
+
+This file is from https://github.com/mapbox/protozero where you can find more
+documentation.
+
+*****************************************************************************/
+
+/**
+ * @file buffer_tmpl.hpp
+ *
+ * @brief Contains the customization points for buffer implementations.
+ */
+
+#include <protozero/config.hpp>
+
+#include <cstddef>
+#include <iterator>
+
+namespace protozero {
+
+/**
+ * This struct is used to tell the basic_pbf_writer how to work with the
+ * buffer it writes into. All access to the buffer goes through the static
+ * functions of this struct.
+ *
+ * The default implementation works with any container of chars that has the
+ * usual `size()`, `data()`, `insert()`, `erase()`, `resize()`, `reserve()`,
+ * and `push_back()` member functions (like `std::string` or
+ * `std::vector<char>`). The data in the buffer must be contiguous.
+ *
+ * For other buffer types you can specialize this template.
+ *
+ * @tparam T Type of the buffer.
+ * @tparam Enable Helper parameter to allow partial specializations using
+ *         `std::enable_if`.
+ */
+template <typename T, typename Enable = void>
+struct buffer_customization {
+
+    /// Get the number of bytes currently in the buffer.
+    static std::size_t size(const T* buffer) noexcept {
+        return buffer->size();
+    }
+
+    /// Append count bytes from data to the buffer.
+    static void append(T* buffer, const char* data, std::size_t count) {
+        buffer->insert(buffer->end(), data, data + count);
+    }
+
+    /// Append count zero bytes to the buffer.
+    static void append_zeros(T* buffer, std::size_t count) {
+        buffer->resize(buffer->size() + count);
+    }
+
+    /// Shrink the buffer to the given size.
+    static void resize(T* buffer, std::size_t size) {
+        protozero_assert(size <= buffer->size());
+        buffer->resize(size);
+    }
+
+    /// Make sure there is room for size more bytes in the buffer.
+    static void reserve_additional(T* buffer, std::size_t size) {
+        buffer->reserve(buffer->size() + size);
+    }
+
+    /// Remove the bytes from position from to position to from the buffer.
+    static void erase_range(T* buffer, std::size_t from, std::size_t to) {
+        protozero_assert(from <= buffer->size());
+        protozero_assert(to <= buffer->size());
+        protozero_assert(from <= to);
+        buffer->erase(std::next(buffer->begin(), static_cast<typename T::difference_type>(from)),
+                      std::next(buffer->begin(), static_cast<typename T::difference_type>(to)));
+    }
+
+    /// Get a pointer to the byte at position pos in the buffer.
+    static char* at_pos(T* buffer, std::size_t pos) {
+        protozero_assert(pos <= buffer->size());
+        return &*buffer->begin() + pos;
+    }
+
+    /// Append one byte to the buffer.
+    static void push_back(T* buffer, char ch) {
+        buffer->push_back(ch);
+    }
+
+}; // struct buffer_customization
+
+} // end namespace protozero
+
+#endif // PROTOZERO_BUFFER_TMPL_HPP
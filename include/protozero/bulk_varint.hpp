@@ -0,0 +1,683 @@
+#ifndef PROTOZERO_BULK_VARINT_HPP
+#define PROTOZERO_BULK_VARINT_HPP
+
+/*****************************************************************************
+
+protozero - Minimalistic protocol buffer decoder and encoder in C++.
+
+This file is from https://github.com/mapbox/protozero where you can find more
+documentation.
+
+*****************************************************************************/
+
+/**
+ * @file bulk_varint.hpp
+ *
+ * @brief Contains functions for decoding all values in a packed repeated
+ *        field in one go.
+ */
+
+#include <protozero/config.hpp>
+#include <protozero/iterators.hpp>
+#include <protozero/varint.hpp>
+
+#if PROTOZERO_BYTE_ORDER != PROTOZERO_LITTLE_ENDIAN
+# include <protozero/byteswap.hpp>
+#endif
+
+#if defined(PROTOZERO_USE_AVX2) || defined(PROTOZERO_USE_BMI2)
+# include <immintrin.h>
+#endif
+#if defined(PROTOZERO_USE_SSE2) && !defined(PROTOZERO_USE_AVX2)
+# include <emmintrin.h>
+#endif
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace protozero {
+
+namespace detail {
+
+    // Number of bytes looked at in one step by the block decoder. The
+    // decoder needs this many bytes plus some slack for the 8-byte loads
+    // at the end of the block, smaller buffers are decoded byte by byte.
+#ifdef PROTOZERO_USE_AVX2
+    constexpr const int varint_block_size = 32;
+#else
+    constexpr const int varint_block_size = 16;
+#endif
+
+    constexpr const int varint_block_slack = 8;
+
+    // Get the index of the lowest bit set in value. Must not be called
+    // with 0.
+    inline int count_trailing_zeros(uint32_t value) noexcept {
+#ifdef PROTOZERO_USE_BUILTIN_CTZ
+        return __builtin_ctz(value);
+#else
+        int n = 0;
+        while ((value & 1U) == 0) {
+            value >>= 1U;
+            ++n;
+        }
+        return n;
+#endif
+    }
+
+    // Get the number of bits set in value.
+    inline int count_bits(uint32_t value) noexcept {
+#ifdef PROTOZERO_USE_BUILTIN_POPCOUNT
+        return __builtin_popcount(value);
+#else
+        int n = 0;
+        while (value != 0) {
+            value &= value - 1U;
+            ++n;
+        }
+        return n;
+#endif
+    }
+
+    // Load 8 bytes in little endian order.
+    inline uint64_t load_varint_bytes(const char* data) noexcept {
+        uint64_t value;
+        std::memcpy(&value, data, sizeof(value));
+#if PROTOZERO_BYTE_ORDER != PROTOZERO_LITTLE_ENDIAN
+        byteswap_inplace(&value);
+#endif
+        return value;
+    }
+
+    // Get a bit mask with bit n set if byte n of the block starting at data
+    // has its most significant bit (the varint continuation bit) set.
+    inline uint32_t continuation_bits(const char* data) noexcept {
+#if defined(PROTOZERO_USE_AVX2)
+        return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data))));
+#elif defined(PROTOZERO_USE_SSE2)
+        return static_cast<uint32_t>(_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data))));
+#else
+        uint32_t mask = 0;
+        for (int n = 0; n < varint_block_size; n += 8) {
+            // Move the msb of every byte to the lowest bit of that byte, then
+            // gather those bits into the top byte with one multiplication.
+            const uint64_t msbs = (load_varint_bytes(data + n) >> 7U) & 0x0101010101010101ULL;
+            mask |= static_cast<uint32_t>((msbs * 0x0102040810204080ULL) >> 56U) << static_cast<unsigned int>(n);
+        }
+        return mask;
+#endif
+    }
+
+    // Decode a varint of at most 8 bytes from the lowest bytes of value.
+    // The bytes above the varint must already be masked out.
+    inline uint64_t compact_varint_bytes(uint64_t value) noexcept {
+#ifdef PROTOZERO_USE_BMI2
+        return _pext_u64(value, 0x7f7f7f7f7f7f7f7fULL);
+#else
+        value &= 0x7f7f7f7f7f7f7f7fULL;
+        value = (value & 0x007f007f007f007fULL) | ((value & 0x7f007f007f007f00ULL) >> 1U);
+        value = (value & 0x00003fff00003fffULL) | ((value & 0x3fff00003fff0000ULL) >> 2U);
+        value = (value & 0x000000000fffffffULL) | ((value & 0x0fffffff00000000ULL) >> 4U);
+        return value;
+#endif
+    }
+
+    // Count the varints between data and end. Every varint has exactly one
+    // byte without the continuation bit, so those bytes are counted for a
+    // whole block at once.
+    inline std::size_t count_varints(const char* data, const char* end) noexcept {
+        constexpr const uint32_t all_bits = varint_block_size == 32 ? 0xffffffffU : (1U << static_cast<unsigned int>(varint_block_size)) - 1U;
+
+        std::size_t count = 0;
+        while (end - data >= varint_block_size) {
+            count += static_cast<std::size_t>(count_bits(~continuation_bits(data) & all_bits));
+            data += varint_block_size;
+        }
+        for (; data != end; ++data) {
+            if ((static_cast<uint8_t>(*data) & 0x80U) == 0) {
+                ++count;
+            }
+        }
+        return count;
+    }
+
+    // Decode all varints between *data and end calling emit() for each
+    // value. The boundaries of the varints are found for a whole block of
+    // bytes at once and all varints of up to 8 bytes are decoded without
+    // any data-dependent branches. Blocks containing only one-byte varints
+    // are handed to emit_block() in one go.
+    template <typename TEmit, typename TEmitBlock>
+    inline void decode_varint_blocks(const char** data, const char* end, TEmit&& emit, TEmitBlock&& emit_block) {
+        constexpr const uint32_t all_bits = varint_block_size == 32 ? 0xffffffffU : (1U << static_cast<unsigned int>(varint_block_size)) - 1U;
+
+        const char* p = *data;
+        while (end - p >= varint_block_size + varint_block_slack) {
+            const uint32_t continuation = continuation_bits(p);
+
+            if (continuation == 0) {
+                // Common case for small values: all varints are one byte.
+                emit_block(p);
+                p += varint_block_size;
+                continue;
+            }
+
+            uint32_t last_bytes = ~continuation & all_bits;
+            if (last_bytes == 0) {
+                // No varint ends in this block, so it must be too long.
+                // Let the normal decoder handle (and report) this.
+                emit(decode_varint(&p, end));
+                continue;
+            }
+
+            const char* start = p;
+            do {
+                const char* last = p + count_trailing_zeros(last_bytes);
+                const auto length = static_cast<unsigned int>(last - start) + 1U;
+                if (length <= 8) {
+                    const uint64_t mask = ~uint64_t(0) >> (64U - 8U * length);
+                    emit(compact_varint_bytes(load_varint_bytes(start) & mask));
+                } else {
+                    const char* d = start;
+                    emit(decode_varint(&d, end));
+                }
+                start = last + 1;
+                last_bytes &= last_bytes - 1;
+            } while (last_bytes != 0);
+
+            // Any bytes left in the block belong to a varint continuing
+            // in the next block.
+            p = start;
+        }
+
+        while (p != end) {
+            emit(decode_varint(&p, end));
+        }
+
+        *data = p;
+    }
+
+    template <typename TEmit>
+    inline void decode_varint_blocks(const char** data, const char* end, TEmit&& emit) {
+        decode_varint_blocks(data, end, emit, [&emit](const char* block) {
+            for (int n = 0; n < varint_block_size; ++n) {
+                emit(static_cast<uint64_t>(static_cast<uint8_t>(block[n])));
+            }
+        });
+    }
+
+    // Decode a block of zigzag-encoded one-byte varints adding each value
+    // to the running *sum and writing the sums to out.
+    template <typename T, typename TSum>
+    inline T* delta_decode_block(const char* data, T* out, TSum* sum) noexcept {
+        for (int n = 0; n < varint_block_size; ++n) {
+            *sum += static_cast<TSum>(decode_zigzag64(static_cast<uint8_t>(data[n])));
+            *out++ = static_cast<T>(*sum);
+        }
+        return out;
+    }
+
+#ifdef PROTOZERO_USE_SSE2
+    // Add up 16 bit values in all lanes: lane n gets the sum of lanes 0..n.
+    inline __m128i prefix_sum_epi16(__m128i value) noexcept {
+        value = _mm_add_epi16(value, _mm_slli_si128(value, 2));
+        value = _mm_add_epi16(value, _mm_slli_si128(value, 4));
+        return _mm_add_epi16(value, _mm_slli_si128(value, 8));
+    }
+
+    // SSE2 version for 32 bit output. A zigzag-encoded one-byte varint is
+    // in the range -64..63, so eight of them can be added up in 16 bit
+    // lanes before they are widened to 32 bit and the running sum is added.
+    inline int32_t* delta_decode_block(const char* data, int32_t* out, uint32_t* sum) noexcept {
+        __m128i carry = _mm_set1_epi32(static_cast<int32_t>(*sum));
+        for (int n = 0; n < varint_block_size; n += 16) {
+            const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + n));
+
+            // (b >> 1) ^ -(b & 1) on all bytes, there is no 8 bit shift.
+            const __m128i half = _mm_and_si128(_mm_srli_epi16(bytes, 1), _mm_set1_epi8(0x7f));
+            const __m128i sign = _mm_sub_epi8(_mm_setzero_si128(), _mm_and_si128(bytes, _mm_set1_epi8(1)));
+            const __m128i values = _mm_xor_si128(half, sign);
+
+            // Sign extend to 16 bit by putting each byte in the upper half.
+            const __m128i parts[2] = {_mm_srai_epi16(_mm_unpacklo_epi8(values, values), 8),
+                                      _mm_srai_epi16(_mm_unpackhi_epi8(values, values), 8)};
+
+            for (const __m128i part : parts) {
+                const __m128i sums = prefix_sum_epi16(part);
+                const __m128i lo = _mm_add_epi32(_mm_srai_epi32(_mm_unpacklo_epi16(sums, sums), 16), carry);
+                const __m128i hi = _mm_add_epi32(_mm_srai_epi32(_mm_unpackhi_epi16(sums, sums), 16), carry);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out), lo);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 4), hi);
+                out += 8;
+                carry = _mm_shuffle_epi32(hi, 0xff);
+            }
+        }
+        *sum = static_cast<uint32_t>(_mm_cvtsi128_si32(carry));
+        return out;
+    }
+#endif
+
+} // end namespace detail
+
+/**
+ * Decode all varints from the buffer and write them into the output array.
+ * This is usually much faster than iterating over the values of a packed
+ * repeated field with a const_varint_iterator.
+ *
+ * If an exception is thrown, the data pointer will not be changed, but the
+ * output array might have been partially written to.
+ *
+ * @tparam T The type of the values to decode into (usually an integer type).
+ * @param[in,out] data Pointer to pointer to the input data. After the function
+ *        returns this will point to end.
+ * @param[in] end Pointer one past the end of the input data.
+ * @param[out] out Pointer to the beginning of the output array. There must
+ *        be room for as many values as there are varints in the buffer. If
+ *        you don't know how many varints there are, you can use the number
+ *        of bytes in the buffer which is always enough.
+ * @returns Pointer one past the last value written.
+ * @throws varint_too_long_exception if a varint is longer than the maximum
+ *         length that would fit in a 64 bit int.
+ * @throws end_of_buffer_exception if the last varint is incomplete.
+ */
+template <typename T>
+T* decode_packed_varint(const char** data, const char* end, T* out) {
+    const char* d = *data;
+    detail::decode_varint_blocks(&d, end, [&out](uint64_t value) {
+        *out++ = static_cast<T>(value);
+    });
+    *data = d;
+    return out;
+}
+
+/**
+ * Decode all zigzag-encoded varints from the buffer and write them into the
+ * output array. Works like decode_packed_varint(), but decodes the
+ * values of "sint32" or "sint64" fields.
+ *
+ * @tparam T The type of the values to decode into (usually a signed
+ *         integer type).
+ * @param[in,out] data Pointer to pointer to the input data. After the function
+ *        returns this will point to end.
+ * @param[in] end Pointer one past the end of the input data.
+ * @param[out] out Pointer to the beginning of the output array. There must
+ *        be room for as many values as there are varints in the buffer.
+ * @returns Pointer one past the last value written.
+ * @throws varint_too_long_exception if a varint is longer than the maximum
+ *         length that would fit in a 64 bit int.
+ * @throws end_of_buffer_exception if the last varint is incomplete.
+ */
+template <typename T>
+T* decode_packed_svarint(const char** data, const char* end, T* out) {
+    const char* d = *data;
+    detail::decode_varint_blocks(&d, end, [&out](uint64_t value) {
+        *out++ = static_cast<T>(decode_zigzag64(value));
+    });
+    *data = d;
+    return out;
+}
+
+/**
+ * Decode all zigzag-encoded varints from the buffer as deltas and write the
+ * running sums into the output array. This is how coordinates and IDs are
+ * often stored, for instance in the DenseNodes of OSM data. Varint
+ * decoding, zigzag decoding and the prefix sum are done
+ * in one pass. For 32 bit output, blocks of small deltas are decoded using
+ * SSE2 if available.
+ *
+ * @code
+ *    // deltas 3, -1, 5 become 103, 102, 107
+ *    protozero::decode_packed_svarint_delta(&data, end, out, int32_t(100));
+ * @endcode
+ *
+ * Sums wrap around on overflow like unsigned integers would. If an
+ * exception is thrown, the data pointer will not be changed, but the output
+ * array might have been partially written to.
+ *
+ * @tparam T The type of the values to decode into, int32_t or int64_t.
+ * @param[in,out] data Pointer to pointer to the input data. After the function
+ *        returns this will point to end.
+ * @param[in] end Pointer one past the end of the input data.
+ * @param[out] out Pointer to the beginning of the output array. There must
+ *        be room for as many values as there are varints in the buffer.
+ * @param[in] base The value the first delta is added to.
+ * @returns Pointer one past the last value written.
+ * @throws varint_too_long_exception if a varint is longer than the maximum
+ *         length that would fit in a 64 bit int.
+ * @throws end_of_buffer_exception if the last varint is incomplete.
+ */
+template <typename T>
+T* decode_packed_svarint_delta(const char** data, const char* end, T* out, T base = 0) {
+    static_assert(std::is_integral<T>::value && std::is_signed<T>::value, "T must be a signed integer type");
+    using sum_type = typename std::make_unsigned<T>::type;
+
+    const char* d = *data;
+    auto sum = static_cast<sum_type>(base);
+    detail::decode_varint_blocks(&d, end, [&out, &sum](uint64_t value) {
+        sum += static_cast<sum_type>(decode_zigzag64(value));
+        *out++ = static_cast<T>(sum);
+    }, [&out, &sum](const char* block) {
+        out = detail::delta_decode_block(block, out, &sum);
+    });
+    *data = d;
+    return out;
+}
+
+/**
+ * Decode all values in a range of varints as returned by
+ * pbf_reader::get_packed_uint32() and similar functions.
+ *
+ * @code
+ *    auto range = message.get_packed_uint32();
+ *    std::vector<uint32_t> values(range.size());
+ *    protozero::decode_packed(range, values.data());
+ * @endcode
+ *
+ * @param range The range of values.
+ * @param[out] out Pointer to the beginning of the output array. There must
+ *        be room for range.size() values.
+ * @returns Pointer one past the last value written.
+ * @throws varint_too_long_exception if a varint is longer than the maximum
+ *         length that would fit in a 64 bit int.
+ * @throws end_of_buffer_exception if the last varint is incomplete.
+ */
+template <typename T>
+T* decode_packed(const iterator_range<const_varint_iterator<T>>& range, T* out) {
+    const char* data = range.begin().data();
+    return decode_packed_varint(&data, range.end().data(), out);
+}
+
+/**
+ * Decode all values in a range of zigzag-encoded varints as returned by
+ * pbf_reader::get_packed_sint32() and pbf_reader::get_packed_sint64().
+ *
+ * @param range The range of values.
+ * @param[out] out Pointer to the beginning of the output array. There must
+ *        be room for range.size() values.
+ * @returns Pointer one past the last value written.
+ * @throws varint_too_long_exception if a varint is longer than the maximum
+ *         length that would fit in a 64 bit int.
+ * @throws end_of_buffer_exception if the last varint is incomplete.
+ */
+template <typename T>
+T* decode_packed(const iterator_range<const_svarint_iterator<T>>& range, T* out) {
+    const char* data = range.begin().data();
+    return decode_packed_svarint(&data, range.end().data(), out);
+}
+
+/**
+ * Decode all values in a range of zigzag-encoded varints as returned by
+ * pbf_reader::get_packed_sint32() and pbf_reader::get_packed_sint64() as
+ * deltas and write the running sums into the output array. See
+ * decode_packed_svarint_delta() for details.
+ *
+ * @code
+ *    auto range = dense_nodes.get_packed_sint64();
+ *    std::vector<int64_t> ids(range.size());
+ *    protozero::decode_packed_delta(range, ids.data());
+ * @endcode
+ *
+ * @param range The range of values.
+ * @param[out] out Pointer to the beginning of the output array. There must
+ *        be room for range.size() values.
+ * @param[in] base The value the first delta is added to.
+ * @returns Pointer one past the last value written.
+ * @throws varint_too_long_exception if a varint is longer than the maximum
+ *         length that would fit in a 64 bit int.
+ * @throws end_of_buffer_exception if the last varint is incomplete.
+ */
+template <typename T>
+T* decode_packed_delta(const iterator_range<const_svarint_iterator<T>>& range, T* out, T base = 0) {
+    const char* data = range.begin().data();
+    return decode_packed_svarint_delta(&data, range.end().data(), out, base);
+}
+
+/**
+ * Decode all values in a range of fixed-size values as returned by
+ * pbf_reader::get_packed_fixed32(), pbf_reader::get_packed_double() and
+ * similar functions. On little-endian machines this is a single memcpy.
+ *
+ * @param range The range of values.
+ * @param[out] out Pointer to the beginning of the output array. There must
+ *        be room for range.size() values.
+ * @returns Pointer one past the last value written.
+ */
+template <typename T>
+T* decode_packed(const iterator_range<const_fixed_iterator<T>>& range, T* out) noexcept {
+#if PROTOZERO_BYTE_ORDER == PROTOZERO_LITTLE_ENDIAN
+    const auto size = static_cast<std::size_t>(range.end().data() - range.begin().data());
+    if (size > 0) {
+        std::memcpy(out, range.begin().data(), size);
+    }
+    return out + size / sizeof(T);
+#else
+    return std::copy(range.begin(), range.end(), out);
+#endif
+}
+
+/// @cond INTERNAL
+namespace detail {
+
+    // Number of bytes in the range. This is the number of values for
+    // fixed-size ranges and an upper bound for the number of varints.
+    template <typename TIterator>
+    std::size_t range_bytes(const iterator_range<TIterator>& range) noexcept {
+        return static_cast<std::size_t>(range.end().data() - range.begin().data());
+    }
+
+    // Number of bytes decoded in one step by decode_packed_append().
+    constexpr const std::size_t packed_append_chunk_size = 1024;
+
+    // Decode the values in chunks into a buffer on the stack and append
+    // each chunk to the vector. Each chunk ends at the end of a varint.
+    // Its first packed_append_chunk_size bytes can contain at most that
+    // many ends of varints, and if the chunk is extended to the end of the
+    // varint, its last byte was not one of them, so the buffer is always
+    // large enough.
+    template <typename TIterator, typename T>
+    void decode_packed_append(const iterator_range<TIterator>& range, std::vector<T>& out) {
+        using value_type = typename std::iterator_traits<TIterator>::value_type;
+        value_type buffer[packed_append_chunk_size];
+
+        const char* data = range.begin().data();
+        const char* const end = range.end().data();
+        const auto old_size = out.size();
+
+        // Counting the varints is much cheaper than decoding them and
+        // avoids growing the vector several times for large ranges.
+        const auto size = old_size + count_varints(data, end);
+        if (size > out.capacity()) {
+            out.reserve(std::max(size, 2 * out.capacity()));
+        }
+
+        try {
+            while (data != end) {
+                const char* chunk_end = data + std::min(packed_append_chunk_size, static_cast<std::size_t>(end - data));
+                while (chunk_end != end && (static_cast<uint8_t>(chunk_end[-1]) & 0x80U) != 0) {
+                    ++chunk_end;
+                }
+                const iterator_range<TIterator> chunk{TIterator{data, chunk_end}, TIterator{chunk_end, chunk_end}};
+                value_type* const last = decode_packed(chunk, buffer);
+                out.insert(out.end(), buffer, last);
+                data = chunk_end;
+            }
+        } catch (...) {
+            out.resize(old_size);
+            throw;
+        }
+    }
+
+    template <typename TIterator, typename T>
+    std::size_t decode_packed_checked(const iterator_range<TIterator>& range, T* out, std::size_t capacity) {
+        // Only count the values if there might not be enough room.
+        if (range_bytes(range) > capacity && range.size() > capacity) {
+            throw std::length_error{"packed field has more values than fit into output"};
+        }
+        return static_cast<std::size_t>(decode_packed(range, out) - out);
+    }
+
+} // end namespace detail
+/// @endcond
+
+/**
+ * Decode all values in a range of varints as returned by
+ * pbf_reader::get_packed_uint32() and similar functions and append them
+ * to a vector.
+ *
+ * @code
+ *    std::vector<uint32_t> values;
+ *    while (message.next(1)) {
+ *        protozero::decode_packed_into(message.get_packed_uint32(), values);
+ *    }
+ * @endcode
+ *
+ * The varints are counted first, looking only at the continuation bits of
+ * a whole block of bytes at once, so that the vector grows at most once.
+ * Then they are decoded in chunks into a buffer on the stack which is
+ * appended to the vector. No memory is allocated for more values than
+ * there are (apart from the usual doubling of the capacity of a vector).
+ *
+ * Strong exception guarantee: if there is an exception the vector will have
+ * its old size and contents.
+ *
+ * @param range The range of values.
+ * @param[in,out] out The vector the values are appended to.
+ * @throws varint_too_long_exception if a varint is longer than the maximum
+ *         length that would fit in a 64 bit int.
+ * @throws end_of_buffer_exception if the last varint is incomplete.
+ * @throws Any exception thrown when the vector grows.
+ */
+template <typename T>
+void decode_packed_into(const iterator_range<const_varint_iterator<T>>& range, std::vector<T>& out) {
+    detail::decode_packed_append(range, out);
+}
+
+/**
+ * Decode all values in a range of zigzag-encoded varints as returned by
+ * pbf_reader::get_packed_sint32() and pbf_reader::get_packed_sint64() and
+ * append them to a vector. Works like the overload for varints.
+ *
+ * @param range The range of values.
+ * @param[in,out] out The vector the values are appended to.
+ * @throws varint_too_long_exception if a varint is longer than the maximum
+ *         length that would fit in a 64 bit int.
+ * @throws end_of_buffer_exception if the last varint is incomplete.
+ * @throws Any exception thrown when the vector grows.
+ */
+template <typename T>
+void decode_packed_into(const iterator_range<const_svarint_iterator<T>>& range, std::vector<T>& out) {
+    detail::decode_packed_append(range, out);
+}
+
+/**
+ * Decode all values in a range of bools as returned by
+ * pbf_reader::get_packed_bool() and append them to a vector. Works like
+ * the overload for varints.
+ *
+ * @param range The range of values.
+ * @param[in,out] out The vector the values are appended to.
+ * @throws varint_too_long_exception if a varint is longer than the maximum
+ *         length that would fit in a 64 bit int.
+ * @throws end_of_buffer_exception if the last varint is incomplete.
+ * @throws Any exception thrown when the vector grows.
+ */
+inline void decode_packed_into(const iterator_range<const_varint_iterator<int32_t>>& range, std::vector<bool>& out) {
+    detail::decode_packed_append(range, out);
+}
+
+/**
+ * Decode all values in a range of fixed-size values as returned by
+ * pbf_reader::get_packed_fixed32(), pbf_reader::get_packed_double() and
+ * similar functions and append them to a vector. On little-endian machines
+ * the values are copied with a single memcpy.
+ *
+ * @param range The range of values.
+ * @param[in,out] out The vector the values are appended to.
+ * @throws Any exception thrown when the vector grows.
+ */
+template <typename T>
+void decode_packed_into(const iterator_range<const_fixed_iterator<T>>& range, std::vector<T>& out) {
+#if PROTOZERO_BYTE_ORDER == PROTOZERO_LITTLE_ENDIAN
+    const auto size = detail::range_bytes(range);
+    if (size == 0) {
+        return;
+    }
+    const auto old_size = out.size();
+    out.resize(old_size + size / sizeof(T));
+    std::memcpy(out.data() + old_size, range.begin().data(), size);
+#else
+    out.insert(out.end(), range.begin(), range.end());
+#endif
+}
+
+/**
+ * Decode all values in a range of varints as returned by
+ * pbf_reader::get_packed_uint32() and similar functions into an array of
+ * the specified capacity.
+ *
+ * The values are only counted before decoding if the range has more bytes
+ * than the capacity, otherwise there is always enough room.
+ *
+ * @param range The range of values.
+ * @param[out] out Pointer to the beginning of the output array.
+ * @param capacity The number of values the output array can hold.
+ * @returns The number of values written.
+ * @throws std::length_error if there are more than capacity values. Nothing
+ *         is written in this case.
+ * @throws varint_too_long_exception if a varint is longer than the maximum
+ *         length that would fit in a 64 bit int.
+ * @throws end_of_buffer_exception if the last varint is incomplete.
+ */
+template <typename T>
+std::size_t decode_packed_into(const iterator_range<const_varint_iterator<T>>& range, T* out, std::size_t capacity) {
+    return detail::decode_packed_checked(range, out, capacity);
+}
+
+/**
+ * Decode all values in a range of zigzag-encoded varints as returned by
+ * pbf_reader::get_packed_sint32() and pbf_reader::get_packed_sint64() into
+ * an array of the specified capacity. Works like the overload for varints.
+ *
+ * @param range The range of values.
+ * @param[out] out Pointer to the beginning of the output array.
+ * @param capacity The number of values the output array can hold.
+ * @returns The number of values written.
+ * @throws std::length_error if there are more than capacity values. Nothing
+ *         is written in this case.
+ * @throws varint_too_long_exception if a varint is longer than the maximum
+ *         length that would fit in a 64 bit int.
+ * @throws end_of_buffer_exception if the last varint is incomplete.
+ */
+template <typename T>
+std::size_t decode_packed_into(const iterator_range<const_svarint_iterator<T>>& range, T* out, std::size_t capacity) {
+    return detail::decode_packed_checked(range, out, capacity);
+}
+
+/**
+ * Decode all values in a range of fixed-size values as returned by
+ * pbf_reader::get_packed_fixed32(), pbf_reader::get_packed_double() and
+ * similar functions into an array of the specified capacity.
+ *
+ * @param range The range of values.
+ * @param[out] out Pointer to the beginning of the output array.
+ * @param capacity The number of values the output array can hold.
+ * @returns The number of values written.
+ * @throws std::length_error if there are more than capacity values. Nothing
+ *         is written in this case.
+ */
+template <typename T>
+std::size_t decode_packed_into(const iterator_range<const_fixed_iterator<T>>& range, T* out, std::size_t capacity) {
+    if (range.size() > capacity) {
+        throw std::length_error{"packed field has more values than fit into output"};
+    }
+    return static_cast<std::size_t>(decode_packed(range, out) - out);
+}
+
+} // end namespace protozero
+
+#endif // PROTOZERO_BULK_VARINT_HPP
@@ -40,6 +40,30 @@ documentation.
 # define PROTOZERO_USE_BUILTIN_BSWAP
 #endif
 
+// Check whether __builtin_ctz, __builtin_clzll and __builtin_popcount are
+// available
+#if defined(__GNUC__) || defined(__clang__)
+# define PROTOZERO_USE_BUILTIN_CTZ
+# define PROTOZERO_USE_BUILTIN_CLZ
+# define PROTOZERO_USE_BUILTIN_POPCOUNT
+#endif
+
+// Check which SIMD instruction sets can be used. Define PROTOZERO_NO_SIMD
+// to always use the portable code paths. Define PROTOZERO_NO_BMI2 to only
+// disable the use of the BMI2 pext instruction which is very slow on some
+// CPUs (AMD before Zen 3).
+#ifndef PROTOZERO_NO_SIMD
+# if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  define PROTOZERO_USE_SSE2
+# endif
+# if defined(__AVX2__)
+#  define PROTOZERO_USE_AVX2
+# endif
+# if defined(__BMI2__) && defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__)) && !defined(PROTOZERO_NO_BMI2)
+#  define PROTOZERO_USE_BMI2
+# endif
+#endif
+
 // Wrapper for assert() used for testing
 #ifndef protozero_assert
 # define protozero_assert(x) assert(x)
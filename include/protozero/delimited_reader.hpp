@@ -0,0 +1,365 @@
+#ifndef PROTOZERO_DELIMITED_READER_HPP
+#define PROTOZERO_DELIMITED_READER_HPP
+
+/*****************************************************************************
+
+protozero - Minimalistic protocol buffer decoder and encoder in C++.
+
+This file is from https://github.com/mapbox/protozero where you can find more
+documentation.
+
+*****************************************************************************/
+
+/**
+ * @file delimited_reader.hpp
+ *
+ * @brief Contains the basic_delimited_reader template class and the sources
+ *        it can read from.
+ */
+
+#include <protozero/config.hpp>
+#include <protozero/data_view.hpp>
+#include <protozero/exception.hpp>
+#include <protozero/pbf_reader.hpp>
+#include <protozero/varint.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <utility>
+#include <vector>
+
+#ifndef _WIN32
+# include <cerrno>
+# include <system_error>
+# include <unistd.h>
+#endif
+
+namespace protozero {
+
+/**
+ * Source for the basic_delimited_reader reading from a std::istream.
+ */
+class istream_source {
+
+    std::istream* m_stream;
+
+public:
+
+    /**
+     * Create source reading from the specified stream. The stream must
+     * outlive this object.
+     */
+    explicit istream_source(std::istream& stream) noexcept :
+        m_stream(&stream) {
+    }
+
+    /**
+     * Read up to size bytes into buffer. Waits for at least one byte, then
+     * reads everything the stream buffer reports as available without
+     * blocking, so it doesn't block on a stream connected to a pipe or
+     * socket when a message is complete.
+     *
+     * Some stream buffers can't tell how much data is available (for
+     * instance the one used by std::cin when it is synchronized with
+     * stdio). For those this blocks until size bytes are read or the end
+     * of the stream is reached. Use fd_source to read from pipes or
+     * sockets which stay open in that case.
+     *
+     * @returns The number of bytes read, 0 at the end of the stream.
+     * @throws std::ios_base::failure if there was a read error.
+     */
+    std::size_t read(char* buffer, std::size_t size) {
+        if (size == 0) {
+            return 0;
+        }
+        m_stream->read(buffer, 1);
+        if (m_stream->bad()) {
+            throw std::ios_base::failure{"error reading from stream"};
+        }
+        if (m_stream->gcount() == 0) {
+            return 0;
+        }
+
+        const auto wanted = static_cast<std::streamsize>(size - 1);
+        const auto available = m_stream->rdbuf()->in_avail();
+        if (available < 0) {
+            return 1;
+        }
+        if (available > 0) {
+            return static_cast<std::size_t>(m_stream->rdbuf()->sgetn(buffer + 1, std::min(available, wanted))) + 1;
+        }
+
+        m_stream->read(buffer + 1, wanted);
+        if (m_stream->bad()) {
+            throw std::ios_base::failure{"error reading from stream"};
+        }
+        return static_cast<std::size_t>(m_stream->gcount()) + 1;
+    }
+
+}; // class istream_source
+
+#ifndef _WIN32
+/**
+ * Source for the basic_delimited_reader reading from a file descriptor
+ * (a file, a pipe, a socket, ...). Not available on Windows.
+ */
+class fd_source {
+
+    int m_fd;
+
+public:
+
+    /**
+     * Create source reading from the specified file descriptor. The file
+     * descriptor is not closed by this class.
+     */
+    explicit fd_source(int fd) noexcept :
+        m_fd(fd) {
+    }
+
+    /**
+     * Read up to size bytes into buffer.
+     *
+     * @returns The number of bytes read, 0 at the end of the file.
+     * @throws std::system_error if there was a read error.
+     */
+    std::size_t read(char* buffer, std::size_t size) {
+        while (true) {
+            const auto result = ::read(m_fd, buffer, size);
+            if (result >= 0) {
+                return static_cast<std::size_t>(result);
+            }
+            if (errno != EINTR) {
+                throw std::system_error{errno, std::system_category(), "read failed"};
+            }
+        }
+    }
+
+}; // class fd_source
+#endif
+
+/**
+ * Reads a sequence of length-delimited messages from a source. Each message
+ * is prefixed by its length encoded as varint. This is the format written by
+ * `writeDelimitedTo()` in the Google protobuf library.
+ *
+ * @code
+ *    std::ifstream stream{"messages.pbf", std::ios_base::binary};
+ *    protozero::istream_delimited_reader reader{protozero::istream_source{stream}};
+ *    while (reader.next()) {
+ *        protozero::pbf_reader message = reader.get_message();
+ *        ...
+ *    }
+ * @endcode
+ *
+ * Data is read in large chunks into an internal buffer and messages are
+ * handed out as views into that buffer without copying them. When there is
+ * not enough space at the end of the buffer for the next message, the rest
+ * of the data is moved to the front of the buffer. The buffer grows if a
+ * message is larger than the buffer.
+ *
+ * The reader never waits for more data than needed for the next message,
+ * so it can be used on pipes and sockets which stay open.
+ *
+ * @tparam TSource The source to read from. Must have a member function
+ *         `std::size_t read(char* buffer, std::size_t size)` returning the
+ *         number of bytes read and 0 at the end of the data. It should
+ *         return as soon as some data is available.
+ */
+template <typename TSource>
+class basic_delimited_reader {
+
+    TSource m_source;
+
+    std::vector<char> m_buffer;
+
+    // Maximum size allowed for a message.
+    std::size_t m_max_message_size;
+
+    // Start of data in the buffer not yet handed out.
+    std::size_t m_begin = 0;
+
+    // End of data in the buffer.
+    std::size_t m_end = 0;
+
+    // The current message.
+    data_view m_message{};
+
+    // Has the source reported the end of the data?
+    bool m_eof = false;
+
+    std::size_t available() const noexcept {
+        return m_end - m_begin;
+    }
+
+    // Make room in the buffer for at least size bytes starting at m_begin.
+    void make_room(std::size_t size) {
+        if (m_begin + size <= m_buffer.size()) {
+            return;
+        }
+        std::memmove(m_buffer.data(), m_buffer.data() + m_begin, available());
+        m_end -= m_begin;
+        m_begin = 0;
+        if (size > m_buffer.size()) {
+            m_buffer.resize(std::max(size, m_buffer.size() * 2));
+        }
+    }
+
+    // Read from the source once, as much as fits into the buffer. Returns
+    // false at the end of the data.
+    bool read_some() {
+        if (m_eof) {
+            return false;
+        }
+        const auto count = m_source.read(m_buffer.data() + m_end, m_buffer.size() - m_end);
+        if (count == 0) {
+            m_eof = true;
+            return false;
+        }
+        m_end += count;
+        return true;
+    }
+
+    // Make sure at least size bytes are available in the buffer if at
+    // all possible. Stops reading as soon as there is enough data, so it
+    // doesn't wait for more data than needed on a pipe or socket.
+    void ensure(std::size_t size) {
+        if (available() >= size) {
+            return;
+        }
+        make_room(size);
+        while (available() < size && read_some()) {
+        }
+    }
+
+    // Is the complete length of the next message (or at least as many bytes
+    // as the longest possible length) available?
+    bool length_available() const noexcept {
+        if (available() >= static_cast<std::size_t>(max_varint_length)) {
+            return true;
+        }
+        return std::any_of(m_buffer.data() + m_begin, m_buffer.data() + m_end, [](char c) noexcept {
+            return (static_cast<unsigned char>(c) & 0x80U) == 0;
+        });
+    }
+
+    // Make sure the length of the next message is available in the buffer
+    // if at all possible. This doesn't wait for max_varint_length bytes,
+    // because a short message might be all there is for now.
+    void ensure_length() {
+        if (length_available()) {
+            return;
+        }
+        make_room(max_varint_length);
+        while (!length_available() && read_some()) {
+        }
+    }
+
+public:
+
+    /// The default size of the buffer.
+    static constexpr const std::size_t default_buffer_size = 64UL * 1024UL;
+
+    /// The default maximum size of a message.
+    static constexpr const std::size_t default_max_message_size = 64UL * 1024UL * 1024UL;
+
+    /**
+     * Create a reader.
+     *
+     * @param source The source to read from.
+     * @param buffer_size The initial size of the buffer. It will grow if a
+     *        message doesn't fit.
+     * @param max_message_size The maximum size of a message. Larger messages
+     *        are treated as an error. This prevents corrupted length fields
+     *        from allocating huge amounts of memory.
+     */
+    explicit basic_delimited_reader(TSource source,
+                                    std::size_t buffer_size = default_buffer_size,
+                                    std::size_t max_message_size = default_max_message_size) :
+        m_source(std::move(source)),
+        m_buffer(std::max(buffer_size, static_cast<std::size_t>(max_varint_length))),
+        m_max_message_size(max_message_size) {
+    }
+
+    /**
+     * Read the next message. After this returns `true`, the message is
+     * available through message() or get_message() until the next call to
+     * next().
+     *
+     * @returns `true` if there is a next message, `false` at the end of the
+     *          data.
+     * @throws end_of_buffer_exception if the data ends in the middle of a
+     *         message or its length.
+     * @throws varint_too_long_exception if the length is not a valid varint.
+     * @throws invalid_length_exception if the message is larger than the
+     *         maximum message size.
+     * @throws Any exception thrown by the source.
+     */
+    bool next() {
+        m_message = data_view{};
+
+        ensure_length();
+        if (available() == 0) {
+            return false;
+        }
+
+        const char* p = m_buffer.data() + m_begin;
+        const uint64_t size = decode_varint(&p, m_buffer.data() + m_end);
+        if (size > m_max_message_size) {
+            throw invalid_length_exception{};
+        }
+
+        const auto length_size = static_cast<std::size_t>(p - (m_buffer.data() + m_begin));
+        ensure(length_size + static_cast<std::size_t>(size));
+        if (available() < length_size + size) {
+            throw end_of_buffer_exception{};
+        }
+
+        m_message = data_view{m_buffer.data() + m_begin + length_size, static_cast<std::size_t>(size)};
+        m_begin += length_size + static_cast<std::size_t>(size);
+
+        return true;
+    }
+
+    /**
+     * Get the current message.
+     *
+     * @pre next() must have returned `true`.
+     */
+    data_view message() const noexcept {
+        return m_message;
+    }
+
+    /**
+     * Get a pbf_reader for the current message.
+     *
+     * @pre next() must have returned `true`.
+     */
+    pbf_reader get_message() const noexcept {
+        return pbf_reader{m_message};
+    }
+
+}; // class basic_delimited_reader
+
+/// @cond INTERNAL
+template <typename TSource>
+constexpr const std::size_t basic_delimited_reader<TSource>::default_buffer_size;
+
+template <typename TSource>
+constexpr const std::size_t basic_delimited_reader<TSource>::default_max_message_size;
+/// @endcond
+
+/// Reader for length-delimited messages from a std::istream.
+using istream_delimited_reader = basic_delimited_reader<istream_source>;
+
+#ifndef _WIN32
+/// Reader for length-delimited messages from a file descriptor.
+using fd_delimited_reader = basic_delimited_reader<fd_source>;
+#endif
+
+} // end namespace protozero
+
+#endif // PROTOZERO_DELIMITED_READER_HPP
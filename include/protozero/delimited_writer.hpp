@@ -0,0 +1,387 @@
+#ifndef PROTOZERO_DELIMITED_WRITER_HPP
+#define PROTOZERO_DELIMITED_WRITER_HPP
+
+/*****************************************************************************
+
+protozero - Minimalistic protocol buffer decoder and encoder in C++.
+
+This file is from https://github.com/mapbox/protozero where you can find more
+documentation.
+
+*****************************************************************************/
+
+/**
+ * @file delimited_writer.hpp
+ *
+ * @brief Contains the basic_delimited_writer template class and the sinks
+ *        it can write to.
+ */
+
+#include <protozero/config.hpp>
+#include <protozero/data_view.hpp>
+#include <protozero/pbf_writer.hpp>
+#include <protozero/varint.hpp>
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <utility>
+
+#ifndef _WIN32
+# include <cerrno>
+# include <system_error>
+# include <sys/uio.h>
+# include <unistd.h>
+#endif
+
+namespace protozero {
+
+/**
+ * Sink for the basic_delimited_writer writing to a std::ostream.
+ */
+class ostream_sink {
+
+    std::ostream* m_stream;
+
+public:
+
+    /**
+     * Create sink writing to the specified stream. The stream must outlive
+     * this object.
+     */
+    explicit ostream_sink(std::ostream& stream) noexcept :
+        m_stream(&stream) {
+    }
+
+    /**
+     * Write size bytes from data to the stream.
+     *
+     * @throws std::ios_base::failure if there was a write error.
+     */
+    void write(const char* data, std::size_t size) {
+        m_stream->write(data, static_cast<std::streamsize>(size));
+        if (!*m_stream) {
+            throw std::ios_base::failure{"error writing to stream"};
+        }
+    }
+
+}; // class ostream_sink
+
+#ifndef _WIN32
+/**
+ * Sink for the basic_delimited_writer writing to a file descriptor (a file,
+ * a pipe, a socket, ...). Not available on Windows.
+ */
+class fd_sink {
+
+    int m_fd;
+
+public:
+
+    /**
+     * Create sink writing to the specified file descriptor. The file
+     * descriptor is not closed by this class.
+     */
+    explicit fd_sink(int fd) noexcept :
+        m_fd(fd) {
+    }
+
+    /**
+     * Write size bytes from data to the file descriptor.
+     *
+     * @throws std::system_error if there was a write error.
+     */
+    void write(const char* data, std::size_t size) {
+        while (size > 0) {
+            const auto result = ::write(m_fd, data, size);
+            if (result < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw std::system_error{errno, std::system_category(), "write failed"};
+            }
+            data += result;
+            size -= static_cast<std::size_t>(result);
+        }
+    }
+
+    /**
+     * Write the data described by count iovec structs to the file
+     * descriptor with as few `writev()` calls as possible.
+     *
+     * @throws std::system_error if there was a write error.
+     */
+    void write(const iovec* iov, int count) {
+        while (count > 0) {
+            const auto result = ::writev(m_fd, iov, count);
+            if (result < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw std::system_error{errno, std::system_category(), "write failed"};
+            }
+
+            // Skip the parts written completely and write the rest of a
+            // part written partially on its own.
+            auto written = static_cast<std::size_t>(result);
+            while (count > 0 && written >= iov->iov_len) {
+                written -= iov->iov_len;
+                ++iov;
+                --count;
+            }
+            if (count > 0 && written > 0) {
+                write(static_cast<const char*>(iov->iov_base) + written, iov->iov_len - written);
+                ++iov;
+                --count;
+            }
+        }
+    }
+
+}; // class fd_sink
+#endif
+
+/// @cond INTERNAL
+namespace detail {
+
+#ifndef _WIN32
+    // Write both parts with one call if the sink supports gathered writes.
+    template <typename TSink>
+    auto write_parts(TSink& sink, const char* data1, std::size_t size1, const char* data2, std::size_t size2, int /*preferred*/)
+            -> decltype(sink.write(std::declval<const iovec*>(), 2), void()) {
+        iovec iov[2];
+        iov[0].iov_base = const_cast<char*>(data1);
+        iov[0].iov_len = size1;
+        iov[1].iov_base = const_cast<char*>(data2);
+        iov[1].iov_len = size2;
+        sink.write(iov, 2);
+    }
+#endif
+
+    template <typename TSink>
+    void write_parts(TSink& sink, const char* data1, std::size_t size1, const char* data2, std::size_t size2, long /*fallback*/) {
+        sink.write(data1, size1);
+        sink.write(data2, size2);
+    }
+
+} // end namespace detail
+/// @endcond
+
+/**
+ * Writes a sequence of length-delimited messages to a sink. Each message is
+ * prefixed by its length encoded as varint. This is the format read by
+ * `parseDelimitedFrom()` in the Google protobuf library and by the
+ * basic_delimited_reader class.
+ *
+ * @code
+ *    std::ofstream stream{"messages.pbf", std::ios_base::binary};
+ *    protozero::ostream_delimited_writer writer{protozero::ostream_sink{stream}};
+ *    for (const auto& item : items) {
+ *        writer.add_message([&](protozero::pbf_writer& message) {
+ *            message.add_uint32(1, item.id);
+ *            ...
+ *        });
+ *    }
+ *    writer.flush();
+ * @endcode
+ *
+ * Messages are collected in a buffer which is written to the sink in one go
+ * when it is larger than the flush threshold, so there are only few large
+ * writes. The buffers are reused, so no memory is allocated per message once
+ * they are large enough.
+ *
+ * The destructor flushes the buffer, but ignores any errors. Call flush()
+ * explicitly to make sure all data is written.
+ *
+ * If the sink throws an exception, the buffered data is not changed, it
+ * only contains complete messages. This is only useful if the sink didn't
+ * write anything in the failed call. The fd_sink and the ostream_sink can
+ * fail after writing part of the data, which would be written again by the
+ * next flush. Don't use the writer (or let the destructor flush it) after
+ * such an error.
+ *
+ * @tparam TSink The sink to write to. Must have a member function
+ *         `void write(const char* data, std::size_t size)` writing all data
+ *         or throwing an exception. If it also has a member function
+ *         `void write(const iovec* iov, int count)` (not on Windows), that
+ *         is used to write the length and the data of large messages in
+ *         one call.
+ */
+template <typename TSink>
+class basic_delimited_writer {
+
+    TSink m_sink;
+
+    // Scratch buffer for encoding a message before its length is known.
+    std::string m_message{};
+
+    // Messages not yet written to the sink.
+    std::string m_batch{};
+
+    std::size_t m_flush_threshold;
+
+public:
+
+    /// The default flush threshold.
+    static constexpr const std::size_t default_flush_threshold = 1024UL * 1024UL;
+
+    /**
+     * Create a writer.
+     *
+     * @param sink The sink to write to.
+     * @param flush_threshold Buffered data is written to the sink as soon as
+     *        it is larger than this number of bytes.
+     */
+    explicit basic_delimited_writer(TSink sink, std::size_t flush_threshold = default_flush_threshold) :
+        m_sink(std::move(sink)),
+        m_flush_threshold(flush_threshold) {
+        m_batch.reserve(flush_threshold);
+    }
+
+    /// A basic_delimited_writer can not be copied.
+    basic_delimited_writer(const basic_delimited_writer&) = delete;
+
+    /// A basic_delimited_writer can not be copied.
+    basic_delimited_writer& operator=(const basic_delimited_writer&) = delete;
+
+    /**
+     * A basic_delimited_writer can be moved. The buffered data moves with
+     * it.
+     */
+    basic_delimited_writer(basic_delimited_writer&& other) :
+        m_sink(std::move(other.m_sink)),
+        m_message(std::move(other.m_message)),
+        m_batch(std::move(other.m_batch)),
+        m_flush_threshold(other.m_flush_threshold) {
+        other.m_batch.clear();
+    }
+
+    /**
+     * A basic_delimited_writer can not be move-assigned, because that would
+     * silently drop the buffered data of the writer assigned to.
+     */
+    basic_delimited_writer& operator=(basic_delimited_writer&&) = delete;
+
+    ~basic_delimited_writer() noexcept {
+        try {
+            flush();
+        } catch (...) {
+            // Errors can not be reported from a destructor. Call flush()
+            // explicitly if you need to know about them.
+        }
+    }
+
+    /// The flush threshold.
+    std::size_t flush_threshold() const noexcept {
+        return m_flush_threshold;
+    }
+
+    /// The number of bytes buffered but not yet written to the sink.
+    std::size_t buffered() const noexcept {
+        return m_batch.size();
+    }
+
+    /**
+     * Add a message created by the specified function. The function is
+     * called with a pbf_writer it should add the fields of the message to.
+     *
+     * @param func Function (or other callable) taking a pbf_writer&.
+     * @throws Any exception thrown by the function or the sink.
+     */
+    template <typename TFunc>
+    auto add_message(TFunc&& func) -> decltype(func(std::declval<pbf_writer&>()), void()) {
+        m_message.clear();
+        {
+            pbf_writer writer{m_message};
+            std::forward<TFunc>(func)(writer);
+        }
+        add_message(m_message.data(), m_message.size());
+    }
+
+    /**
+     * Add an already encoded message.
+     *
+     * @param data Pointer to the message data.
+     * @param size Size of the message.
+     * @throws Any exception thrown by the sink. The buffered data is not
+     *         changed in that case.
+     */
+    void add_message(const char* data, std::size_t size) {
+        char length[max_varint_length];
+        const auto length_size = static_cast<std::size_t>(write_varint(length, size));
+
+        // Large messages are written directly instead of copying them into
+        // the batch buffer first. The batch is flushed first, so that the
+        // length is never left in the batch without the message if the
+        // sink throws. The length and the message are written with one
+        // call if the sink supports gathered writes.
+        if (size >= m_flush_threshold) {
+            flush();
+            detail::write_parts(m_sink, length, length_size, data, size, 0);
+            return;
+        }
+
+        // If anything fails, the batch is rolled back, so that it only ever
+        // contains complete messages.
+        const auto old_size = m_batch.size();
+        try {
+            m_batch.append(length, length_size);
+            m_batch.append(data, size);
+            if (m_batch.size() >= m_flush_threshold) {
+                flush();
+            }
+        } catch (...) {
+            m_batch.resize(old_size);
+            throw;
+        }
+    }
+
+    /**
+     * Add an already encoded message.
+     *
+     * @param message The message.
+     * @throws Any exception thrown by the sink.
+     */
+    void add_message(const data_view& message) {
+        add_message(message.data(), message.size());
+    }
+
+    /**
+     * Add an already encoded message.
+     *
+     * @param message The message.
+     * @throws Any exception thrown by the sink.
+     */
+    void add_message(const std::string& message) {
+        add_message(message.data(), message.size());
+    }
+
+    /**
+     * Write all buffered data to the sink.
+     *
+     * @throws Any exception thrown by the sink.
+     */
+    void flush() {
+        if (!m_batch.empty()) {
+            m_sink.write(m_batch.data(), m_batch.size());
+            m_batch.clear();
+        }
+    }
+
+}; // class basic_delimited_writer
+
+/// @cond INTERNAL
+template <typename TSink>
+constexpr const std::size_t basic_delimited_writer<TSink>::default_flush_threshold;
+/// @endcond
+
+/// Writer for length-delimited messages to a std::ostream.
+using ostream_delimited_writer = basic_delimited_writer<ostream_sink>;
+
+#ifndef _WIN32
+/// Writer for length-delimited messages to a file descriptor.
+using fd_delimited_writer = basic_delimited_writer<fd_sink>;
+#endif
+
+} // end namespace protozero
+
+#endif // PROTOZERO_DELIMITED_WRITER_HPP
@@ -0,0 +1,211 @@
+#ifndef PROTOZERO_DISPATCH_TABLE_HPP
+#define PROTOZERO_DISPATCH_TABLE_HPP
+
+/*****************************************************************************
+
+protozero - Minimalistic protocol buffer decoder and encoder in C++.
+
+This file is from https://github.com/mapbox/protozero where you can find more
+documentation.
+
+*****************************************************************************/
+
+/**
+ * @file dispatch_table.hpp
+ *
+ * @brief Contains the dispatch_table template class.
+ */
+
+#include <protozero/config.hpp>
+#include <protozero/pbf_message.hpp>
+#include <protozero/types.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace protozero {
+
+/**
+ * A table of handler functions for the fields of a message, indexed by tag
+ * and wire type. Use it instead of a `switch` statement in a loop over all
+ * fields of a message:
+ *
+ * @code
+ *    enum class Point : protozero::pbf_tag_type {
+ *        x = 1,
+ *        y = 2
+ *    };
+ *
+ *    struct point { int64_t x = 0; int64_t y = 0; };
+ *
+ *    using point_table = protozero::dispatch_table<Point, point>;
+ *    static const point_table table = point_table{}
+ *        .on(Point::x, protozero::pbf_wire_type::varint,
+ *            [](protozero::pbf_message<Point>& m, point& p) { p.x = m.get_sint64(); })
+ *        .on(Point::y, protozero::pbf_wire_type::varint,
+ *            [](protozero::pbf_message<Point>& m, point& p) { p.y = m.get_sint64(); });
+ *
+ *    point p;
+ *    table.decode(protozero::pbf_message<Point>{buffer}, p);
+ * @endcode
+ *
+ * Handlers for small tags are kept in a flat array indexed by the value
+ * returned by pbf_reader::tag_and_type(), so finding the handler for a field
+ * is a single indexed load. Handlers for large tags are found using binary
+ * search. Fields without a handler, including fields with a registered tag
+ * but a different wire type, are skipped (or given to the handler set with
+ * on_unknown()).
+ *
+ * Each handler must read the field value (using one of the get_* functions)
+ * or call skip() on the message.
+ *
+ * Create the table once (for instance as a static const object) and use it
+ * for decoding many messages.
+ *
+ * @tparam T Enum type of the tags of the message. See pbf_message.
+ * @tparam TContext Type of the object the handlers write their results to.
+ */
+template <typename T, typename TContext>
+class dispatch_table {
+
+public:
+
+    /// The type of message read by this table.
+    using message_type = pbf_message<T>;
+
+    /**
+     * The type of the handler functions. Capture-less lambdas can be used,
+     * they are converted to function pointers automatically.
+     */
+    using handler_type = void (*)(message_type& message, TContext& context);
+
+    /**
+     * Handlers for fields with tags up to this value are stored in a flat
+     * array, for larger tags a sorted array is searched.
+     */
+    static constexpr const pbf_tag_type max_dense_tag = 255;
+
+private:
+
+    // Handlers indexed by tag_and_type(). Only as large as needed for the
+    // largest registered tag up to max_dense_tag. A nullptr means there is
+    // no handler.
+    std::vector<handler_type> m_dense{};
+
+    // Handlers for larger tags sorted by tag_and_type().
+    std::vector<std::pair<uint32_t, handler_type>> m_sparse{};
+
+    // Handler for fields without a registered handler, if nullptr the
+    // fields are skipped.
+    handler_type m_unknown = nullptr;
+
+    handler_type find_sparse(uint32_t key) const noexcept {
+        const auto it = std::lower_bound(m_sparse.cbegin(), m_sparse.cend(), key,
+                                         [](const std::pair<uint32_t, handler_type>& entry, uint32_t k) noexcept {
+            return entry.first < k;
+        });
+        if (it != m_sparse.cend() && it->first == key) {
+            return it->second;
+        }
+        return nullptr;
+    }
+
+    handler_type lookup(uint32_t key) const noexcept {
+        const handler_type h = key < m_dense.size() ? m_dense[key] : find_sparse(key);
+        return h ? h : m_unknown;
+    }
+
+public:
+
+    /// Create an empty table. All fields will be skipped.
+    dispatch_table() = default;
+
+    /**
+     * Register a handler for fields with the specified tag and wire type.
+     * Replaces any handler registered before for the same tag and type.
+     *
+     * @param tag The tag of the field.
+     * @param type The wire type of the field.
+     * @param func The handler function.
+     * @returns A reference to this table, so calls can be chained.
+     */
+    dispatch_table& on(T tag, pbf_wire_type type, handler_type func) {
+        const auto t = static_cast<pbf_tag_type>(tag);
+        protozero_assert(((t > 0 && t < 19000) || (t > 19999 && t <= ((1U << 29U) - 1))) && "tag out of range");
+        const uint32_t key = tag_and_type(t, type);
+
+        if (t <= max_dense_tag) {
+            if (key >= m_dense.size()) {
+                m_dense.resize(key + 1, nullptr);
+            }
+            m_dense[key] = func;
+            return *this;
+        }
+
+        const auto it = std::lower_bound(m_sparse.begin(), m_sparse.end(), key,
+                                         [](const std::pair<uint32_t, handler_type>& entry, uint32_t k) noexcept {
+            return entry.first < k;
+        });
+        if (it != m_sparse.end() && it->first == key) {
+            it->second = func;
+        } else {
+            m_sparse.emplace(it, key, func);
+        }
+        return *this;
+    }
+
+    /**
+     * Register a handler for all fields that have no other handler. If no
+     * such handler is set, those fields are skipped.
+     *
+     * @param func The handler function.
+     * @returns A reference to this table, so calls can be chained.
+     */
+    dispatch_table& on_unknown(handler_type func) noexcept {
+        m_unknown = func;
+        return *this;
+    }
+
+    /**
+     * Get the handler for the specified tag and wire type. Returns the
+     * handler set with on_unknown() (which can be a nullptr) if there is
+     * none.
+     */
+    handler_type handler(pbf_tag_type tag, pbf_wire_type type) const noexcept {
+        return lookup(tag_and_type(tag, type));
+    }
+
+    /**
+     * Read all (remaining) fields in the message calling the handler for
+     * each field.
+     *
+     * @param message The message to read.
+     * @param context This is given to each handler.
+     * @throws Any exception thrown by the pbf_message class while reading
+     *         the message or by the handlers.
+     */
+    void decode(message_type message, TContext& context) const {
+        while (message.next()) {
+            const handler_type h = lookup(message.tag_and_type());
+            if (h) {
+                h(message, context);
+            } else {
+                message.skip();
+            }
+        }
+    }
+
+}; // class dispatch_table
+
+/// @cond INTERNAL
+template <typename T, typename TContext>
+constexpr const pbf_tag_type dispatch_table<T, TContext>::max_dense_tag;
+/// @endcond
+
+} // end namespace protozero
+
+#endif // PROTOZERO_DISPATCH_TABLE_HPP
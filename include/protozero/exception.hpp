@@ -96,6 +96,19 @@ struct invalid_length_exception : exception {
     }
 };
 
+/**
+ * This exception is thrown by the geometry_decoder when the geometry of a
+ * vector tile feature contains an unknown command or a command with the
+ * wrong number of parameters or when it doesn't start with a MoveTo
+ * command.
+ */
+struct invalid_geometry_exception : exception {
+    /// Returns the explanatory string.
+    const char* what() const noexcept override {
+        return "invalid geometry exception";
+    }
+};
+
 } // end namespace protozero
 
 #endif // PROTOZERO_EXCEPTION_HPP
@@ -0,0 +1,239 @@
+#ifndef PROTOZERO_FIELD_INDEX_HPP
+#define PROTOZERO_FIELD_INDEX_HPP
+
+/*****************************************************************************
+
+protozero - Minimalistic protocol buffer decoder and encoder in C++.
+
+This file is from https://github.com/mapbox/protozero where you can find more
+documentation.
+
+*****************************************************************************/
+
+/**
+ * @file field_index.hpp
+ *
+ * @brief Contains the field_index class.
+ */
+
+#include <protozero/config.hpp>
+#include <protozero/data_view.hpp>
+#include <protozero/iterators.hpp>
+#include <protozero/pbf_reader.hpp>
+#include <protozero/types.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+namespace protozero {
+
+/**
+ * An index of all fields in a message allowing random access to the fields
+ * by tag.
+ *
+ * The pbf_reader class can only read a message from beginning to end. If you
+ * need to look up several fields in the same message in some other order,
+ * you'd have to scan the message several times. The field_index scans the
+ * message once and remembers where every field is. Fields can then be looked
+ * up by tag in O(log n) time.
+ *
+ * @code
+ *    pbf_reader message{...};
+ *    field_index index{message};
+ *    if (pbf_reader field = index.find(17)) {
+ *        auto value = field.get_uint32();
+ *        ...
+ *    }
+ * @endcode
+ *
+ * The field_index doesn't copy the message data, the data has to stay
+ * available as long as the index is used.
+ */
+class field_index {
+
+public:
+
+    /**
+     * The index entry for a field.
+     */
+    struct entry {
+
+        /// The tag of the field.
+        pbf_tag_type tag;
+
+        /// The wire type of the field.
+        pbf_wire_type wire_type;
+
+        /// The offset of the field (including the key) in the message.
+        std::size_t offset;
+
+        /// The length of the field (including the key) in bytes.
+        std::size_t length;
+
+    }; // struct entry
+
+    /// Iterator over index entries.
+    using const_iterator = std::vector<entry>::const_iterator;
+
+private:
+
+    const char* m_data = nullptr;
+
+    // Index entries sorted by tag, fields with the same tag are in the
+    // order they appear in the message.
+    std::vector<entry> m_entries{};
+
+    struct compare_tag {
+        bool operator()(const entry& e, pbf_tag_type tag) const noexcept {
+            return e.tag < tag;
+        }
+        bool operator()(pbf_tag_type tag, const entry& e) const noexcept {
+            return tag < e.tag;
+        }
+    };
+
+public:
+
+    /**
+     * Create an empty index.
+     */
+    field_index() noexcept = default;
+
+    /**
+     * Create an index of all fields in the message. This is done in one
+     * pass over the message.
+     *
+     * @param message The message. This is a copy, so the pbf_reader given
+     *        by the caller is not changed. If some fields have already been
+     *        read from it, only the remaining fields are indexed.
+     * @throws Any of the exceptions the pbf_reader can throw if the message
+     *         is invalid.
+     */
+    explicit field_index(pbf_reader message) :
+        m_data(message.data().data()) {
+        while (true) {
+            const char* const begin = message.data().data();
+            if (!message.next()) {
+                break;
+            }
+            const pbf_tag_type tag = message.tag();
+            const pbf_wire_type wire_type = message.wire_type();
+            message.skip();
+            const char* const end = message.data().data();
+            m_entries.push_back(entry{tag,
+                                      wire_type,
+                                      static_cast<std::size_t>(begin - m_data),
+                                      static_cast<std::size_t>(end - begin)});
+        }
+
+        std::stable_sort(m_entries.begin(), m_entries.end(), [](const entry& a, const entry& b) noexcept {
+            return a.tag < b.tag;
+        });
+    }
+
+    /**
+     * Create an index of all fields in the message.
+     *
+     * @param data The message.
+     * @throws Any of the exceptions the pbf_reader can throw if the message
+     *         is invalid.
+     */
+    explicit field_index(const data_view& data) :
+        field_index(pbf_reader{data}) {
+    }
+
+    /// The number of fields in the index.
+    std::size_t size() const noexcept {
+        return m_entries.size();
+    }
+
+    /// Is the index empty?
+    bool empty() const noexcept {
+        return m_entries.empty();
+    }
+
+    /// Iterator to the first index entry. Entries are sorted by tag.
+    const_iterator begin() const noexcept {
+        return m_entries.cbegin();
+    }
+
+    /// Iterator one past the last index entry.
+    const_iterator end() const noexcept {
+        return m_entries.cend();
+    }
+
+    /**
+     * Get all index entries for fields with the specified tag in the order
+     * in which the fields appear in the message.
+     */
+    iterator_range<const_iterator> find_all(pbf_tag_type tag) const {
+        auto range = std::equal_range(m_entries.cbegin(), m_entries.cend(), tag, compare_tag{});
+        return {std::move(range.first), std::move(range.second)};
+    }
+
+    /// Are there any fields with the specified tag?
+    bool contains(pbf_tag_type tag) const {
+        return std::binary_search(m_entries.cbegin(), m_entries.cend(), tag, compare_tag{});
+    }
+
+    /// The number of fields with the specified tag.
+    std::size_t count(pbf_tag_type tag) const {
+        const auto range = find_all(tag);
+        return static_cast<std::size_t>(std::distance(range.begin(), range.end()));
+    }
+
+    /**
+     * Get a view of the data of the field (including the key) described
+     * by the index entry.
+     */
+    data_view view(const entry& e) const noexcept {
+        return data_view{m_data + e.offset, e.length};
+    }
+
+    /**
+     * Get a pbf_reader for the field described by the index entry. The
+     * pbf_reader is positioned on the field, ie. next() has already been
+     * called on it and you can call one of the get_* functions to read the
+     * value.
+     */
+    pbf_reader get(const entry& e) const {
+        pbf_reader reader{view(e)};
+        reader.next();
+        return reader;
+    }
+
+    /**
+     * Get a pbf_reader positioned on the first field with the specified tag.
+     * If there is no such field, an empty pbf_reader is returned which will
+     * evaluate to false in a boolean context.
+     */
+    pbf_reader find(pbf_tag_type tag) const {
+        const auto it = std::lower_bound(m_entries.cbegin(), m_entries.cend(), tag, compare_tag{});
+        if (it == m_entries.cend() || it->tag != tag) {
+            return pbf_reader{};
+        }
+        return get(*it);
+    }
+
+    /**
+     * Get a pbf_reader positioned on the first field with the specified tag
+     * and wire type. If there is no such field, an empty pbf_reader is
+     * returned which will evaluate to false in a boolean context.
+     */
+    pbf_reader find(pbf_tag_type tag, pbf_wire_type type) const {
+        for (const auto& e : find_all(tag)) {
+            if (e.wire_type == type) {
+                return get(e);
+            }
+        }
+        return pbf_reader{};
+    }
+
+}; // class field_index
+
+} // end namespace protozero
+
+#endif // PROTOZERO_FIELD_INDEX_HPP
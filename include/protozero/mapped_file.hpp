@@ -0,0 +1,234 @@
+#ifndef PROTOZERO_MAPPED_FILE_HPP
+#define PROTOZERO_MAPPED_FILE_HPP
+
+/*****************************************************************************
+
+protozero - Minimalistic protocol buffer decoder and encoder in C++.
+
+This file is from https://github.com/mapbox/protozero where you can find more
+documentation.
+
+*****************************************************************************/
+
+/**
+ * @file mapped_file.hpp
+ *
+ * @brief Contains the mapped_file class. Not available on Windows.
+ */
+
+#include <protozero/config.hpp>
+#include <protozero/data_view.hpp>
+
+#include <cstddef>
+#include <utility>
+
+#ifndef _WIN32
+# include <cerrno>
+# include <string>
+# include <system_error>
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
+
+namespace protozero {
+
+#ifndef _WIN32
+
+/**
+ * How the data of a mapped_file will be accessed. This is given to the
+ * operating system as a hint which can then read ahead more aggressively
+ * (for sequential access) or not at all (for random access).
+ */
+enum class mapped_file_access {
+    normal     = 0, ///< No special treatment
+    sequential = 1, ///< Data is read from beginning to end
+    random     = 2, ///< Data is read in no particular order
+    will_need  = 3  ///< Data will be needed soon, start reading it now
+};
+
+/**
+ * A read-only memory mapping of a whole file. The data can be accessed
+ * through a data_view without reading it into memory first, pages are
+ * loaded by the operating system as they are touched. This is useful for
+ * large files that would otherwise have to be copied into a buffer.
+ *
+ * @code
+ *    protozero::mapped_file file{"data.pbf"};
+ *    protozero::pbf_reader message{file.view()};
+ *    ...
+ * @endcode
+ *
+ * Only regular files can be mapped, not pipes or terminals. The data view
+ * is valid as long as the mapped_file object exists.
+ */
+class mapped_file {
+
+    const char* m_data = nullptr;
+    std::size_t m_size = 0;
+
+    static int to_advice(mapped_file_access access) noexcept {
+        switch (access) {
+            case mapped_file_access::sequential:
+                return MADV_SEQUENTIAL;
+            case mapped_file_access::random:
+                return MADV_RANDOM;
+            case mapped_file_access::will_need:
+                return MADV_WILLNEED;
+            default:
+                break;
+        }
+        return MADV_NORMAL;
+    }
+
+    [[noreturn]] static void throw_error(int error, const char* what, const char* filename) {
+        throw std::system_error{error, std::system_category(), std::string{what} + " '" + filename + "'"};
+    }
+
+    void unmap() noexcept {
+        if (m_size > 0) {
+            ::munmap(const_cast<char*>(m_data), m_size);
+        }
+        m_data = nullptr;
+        m_size = 0;
+    }
+
+public:
+
+    /**
+     * Default construct an empty mapping.
+     */
+    mapped_file() noexcept = default;
+
+    /**
+     * Map the specified file into memory.
+     *
+     * @param filename Name of the file.
+     * @param access How the data will be accessed. This is only a hint.
+     * @throws std::system_error if the file can not be opened or mapped.
+     */
+    explicit mapped_file(const char* filename, mapped_file_access access = mapped_file_access::sequential) {
+        int fd = ::open(filename, O_RDONLY); // NOLINT(cppcoreguidelines-pro-type-vararg)
+        while (fd < 0 && errno == EINTR) {
+            fd = ::open(filename, O_RDONLY); // NOLINT(cppcoreguidelines-pro-type-vararg)
+        }
+        if (fd < 0) {
+            throw_error(errno, "can not open", filename);
+        }
+
+        struct stat st; // NOLINT(cppcoreguidelines-pro-type-member-init)
+        if (::fstat(fd, &st) != 0) {
+            const int error = errno;
+            ::close(fd);
+            throw_error(error, "can not stat", filename);
+        }
+
+        if (!S_ISREG(st.st_mode)) {
+            ::close(fd);
+            throw_error(EINVAL, "not a regular file", filename);
+        }
+
+        const auto size = static_cast<std::size_t>(st.st_size);
+        if (size > 0) {
+            void* addr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (addr == MAP_FAILED) { // NOLINT(cppcoreguidelines-pro-type-cstyle-cast)
+                const int error = errno;
+                ::close(fd);
+                throw_error(error, "can not map", filename);
+            }
+            m_data = static_cast<const char*>(addr);
+            m_size = size;
+            // Only a hint, so errors are ignored.
+            ::madvise(addr, size, to_advice(access));
+        }
+
+        // The mapping stays valid after the file descriptor is closed.
+        ::close(fd);
+    }
+
+    /**
+     * Map the specified file into memory.
+     *
+     * @param filename Name of the file.
+     * @param access How the data will be accessed. This is only a hint.
+     * @throws std::system_error if the file can not be opened or mapped.
+     */
+    explicit mapped_file(const std::string& filename, mapped_file_access access = mapped_file_access::sequential) :
+        mapped_file(filename.c_str(), access) {
+    }
+
+    /// A mapped_file can not be copied.
+    mapped_file(const mapped_file&) = delete;
+
+    /// A mapped_file can not be copied.
+    mapped_file& operator=(const mapped_file&) = delete;
+
+    /// A mapped_file can be moved. The moved-from object is empty.
+    mapped_file(mapped_file&& other) noexcept :
+        m_data(other.m_data),
+        m_size(other.m_size) {
+        other.m_data = nullptr;
+        other.m_size = 0;
+    }
+
+    /// A mapped_file can be moved. The moved-from object is empty.
+    mapped_file& operator=(mapped_file&& other) noexcept {
+        if (this != &other) {
+            unmap();
+            std::swap(m_data, other.m_data);
+            std::swap(m_size, other.m_size);
+        }
+        return *this;
+    }
+
+    ~mapped_file() noexcept {
+        unmap();
+    }
+
+    /// Pointer to the data. Is nullptr if the file is empty.
+    const char* data() const noexcept {
+        return m_data;
+    }
+
+    /// The size of the file.
+    std::size_t size() const noexcept {
+        return m_size;
+    }
+
+    /// Is the file empty?
+    bool empty() const noexcept {
+        return m_size == 0;
+    }
+
+    /// Get a view of the whole data.
+    data_view view() const noexcept {
+        return data_view{m_data, m_size};
+    }
+
+    /**
+     * Change the access hint for part of the file. For instance you can
+     * tell the operating system that a range will be needed soon.
+     *
+     * @param offset Start of the range. Is rounded down to a page boundary.
+     * @param size Length of the range.
+     * @param access The new access hint.
+     * @pre offset + size <= size()
+     */
+    void advise(std::size_t offset, std::size_t size, mapped_file_access access) const {
+        protozero_assert(offset <= m_size && size <= m_size - offset);
+        if (size == 0) {
+            return;
+        }
+        const auto page_size = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+        const std::size_t start = offset - (offset % page_size);
+        ::madvise(const_cast<char*>(m_data) + start, size + (offset - start), to_advice(access));
+    }
+
+}; // class mapped_file
+
+#endif
+
+} // end namespace protozero
+
+#endif // PROTOZERO_MAPPED_FILE_HPP
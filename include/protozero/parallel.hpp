@@ -0,0 +1,471 @@
+#ifndef PROTOZERO_PARALLEL_HPP
+#define PROTOZERO_PARALLEL_HPP
+
+/*****************************************************************************
+
+protozero - Minimalistic protocol buffer decoder and encoder in C++.
+
+This file is from https://github.com/mapbox/protozero where you can find more
+documentation.
+
+*****************************************************************************/
+
+/**
+ * @file parallel.hpp
+ *
+ * @brief Contains the thread_pool class and functions for decoding
+ *        submessages and large messages in parallel.
+ */
+
+#include <protozero/config.hpp>
+#include <protozero/data_view.hpp>
+#include <protozero/field_index.hpp>
+#include <protozero/pbf_reader.hpp>
+#include <protozero/types.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace protozero {
+
+/**
+ * A simple fork-join thread pool. The threads are started once and then
+ * used for all calls to for_each_index(), so it is cheap to use the same
+ * pool for many small jobs (like decoding one tile after the other).
+ *
+ * Work is handed out one index at a time from a shared atomic counter, so
+ * threads that are done with cheap items take over more of the remaining
+ * items and the load is balanced even if items differ a lot in size.
+ *
+ * You have to link with the threads library (for instance with
+ * `Threads::Threads` in CMake) if you use this.
+ */
+class thread_pool {
+
+    std::vector<std::thread> m_threads;
+
+    std::mutex m_run_mutex;
+
+    std::mutex m_mutex;
+    std::condition_variable m_start;
+    std::condition_variable m_done;
+    const std::function<void(std::size_t)>* m_job = nullptr;
+    std::size_t m_generation = 0;
+    std::size_t m_running = 0;
+    bool m_stop = false;
+
+    void worker(std::size_t thread) {
+        std::size_t generation = 0;
+        while (true) {
+            const std::function<void(std::size_t)>* job = nullptr;
+            {
+                std::unique_lock<std::mutex> lock{m_mutex};
+                m_start.wait(lock, [this, generation]() {
+                    return m_stop || m_generation != generation;
+                });
+                if (m_stop) {
+                    return;
+                }
+                generation = m_generation;
+                job = m_job;
+            }
+
+            (*job)(thread);
+
+            std::lock_guard<std::mutex> lock{m_mutex};
+            if (--m_running == 0) {
+                m_done.notify_all();
+            }
+        }
+    }
+
+    void stop() noexcept {
+        {
+            std::lock_guard<std::mutex> lock{m_mutex};
+            m_stop = true;
+        }
+        m_start.notify_all();
+        for (auto& thread : m_threads) {
+            thread.join();
+        }
+    }
+
+public:
+
+    /**
+     * Create a thread pool.
+     *
+     * @param num_threads The number of threads working on each job
+     *        including the thread calling for_each_index(), so one less
+     *        thread is started. If this is 0, the number of hardware
+     *        threads is used.
+     * @throws std::system_error if a thread can not be started.
+     */
+    explicit thread_pool(std::size_t num_threads = 0) {
+        if (num_threads == 0) {
+            num_threads = std::thread::hardware_concurrency();
+        }
+        try {
+            for (std::size_t n = 1; n < num_threads; ++n) {
+                m_threads.emplace_back(&thread_pool::worker, this, n);
+            }
+        } catch (...) {
+            stop();
+            throw;
+        }
+    }
+
+    /// A thread_pool can not be copied.
+    thread_pool(const thread_pool&) = delete;
+
+    /// A thread_pool can not be copied.
+    thread_pool& operator=(const thread_pool&) = delete;
+
+    /// A thread_pool can not be moved.
+    thread_pool(thread_pool&&) = delete;
+
+    /// A thread_pool can not be moved.
+    thread_pool& operator=(thread_pool&&) = delete;
+
+    ~thread_pool() noexcept {
+        stop();
+    }
+
+    /**
+     * The number of threads working on each job, including the thread
+     * calling for_each_index().
+     */
+    std::size_t size() const noexcept {
+        return m_threads.size() + 1;
+    }
+
+    /**
+     * Call `func(index, thread)` for each index from 0 to count - 1 using
+     * all threads of the pool and wait until all calls are done. The
+     * calling thread takes part in the work. The thread parameter is the
+     * number of the thread (between 0 and size() - 1) making the call, it
+     * can be used to access per-thread data without locking.
+     *
+     * If calls from different threads of the program overlap, they are
+     * run one after the other. Calling for_each_index() from inside func
+     * on the same pool is not allowed and will deadlock.
+     *
+     * @param count The number of indexes.
+     * @param func The function to call.
+     * @throws Any exception thrown by func. If one call throws, no more
+     *         calls are started and the first exception is rethrown after
+     *         all running calls are done.
+     */
+    template <typename TFunc>
+    void for_each_index(std::size_t count, TFunc&& func) {
+        std::lock_guard<std::mutex> run_lock{m_run_mutex};
+
+        std::atomic<std::size_t> next_index{0};
+        std::exception_ptr error;
+        std::mutex error_mutex;
+
+        const std::function<void(std::size_t)> job = [&](std::size_t thread) {
+            while (true) {
+                const auto index = next_index.fetch_add(1, std::memory_order_relaxed);
+                if (index >= count) {
+                    return;
+                }
+                try {
+                    func(index, thread);
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock{error_mutex};
+                    if (!error) {
+                        error = std::current_exception();
+                    }
+                    next_index.store(count, std::memory_order_relaxed);
+                }
+            }
+        };
+
+        if (m_threads.empty() || count < 2) {
+            job(0);
+        } else {
+            {
+                std::lock_guard<std::mutex> lock{m_mutex};
+                m_job = &job;
+                m_running = m_threads.size();
+                ++m_generation;
+            }
+            m_start.notify_all();
+
+            job(0);
+
+            std::unique_lock<std::mutex> lock{m_mutex};
+            m_done.wait(lock, [this]() {
+                return m_running == 0;
+            });
+        }
+
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+}; // class thread_pool
+
+/**
+ * Get the data of all submessages with the specified tag in a message. This
+ * is a cheap pass over the message only skipping over the submessages.
+ *
+ * @param message The message.
+ * @param tag The tag of the submessages.
+ * @returns Views of the submessages in the order they appear in the message.
+ * @throws Any of the exceptions the pbf_reader can throw if the message is
+ *         invalid.
+ */
+inline std::vector<data_view> collect_submessages(const data_view& message, pbf_tag_type tag) {
+    std::vector<data_view> views;
+    pbf_reader reader{message};
+    while (reader.next(tag, pbf_wire_type::length_delimited)) {
+        views.push_back(reader.get_view());
+    }
+    return views;
+}
+
+/**
+ * Call `func(view)` for each data view using the threads of the pool and
+ * return the results in the same order as the views.
+ *
+ * @code
+ *    protozero::thread_pool pool;
+ *    const auto layers = protozero::collect_submessages(tile, 3);
+ *    const auto results = protozero::parallel_map(pool, layers, [](protozero::data_view layer) {
+ *        return decode_layer(layer);
+ *    });
+ * @endcode
+ *
+ * @tparam TFunc The type of the function. It must return a type that is
+ *         default constructible and move assignable and that is not bool.
+ * @param pool The thread pool.
+ * @param views The data views, usually from collect_submessages().
+ * @param func The function called for each view. It is called from several
+ *        threads at the same time.
+ * @returns Vector with the results.
+ * @throws Any exception thrown by func. See thread_pool::for_each_index().
+ */
+template <typename TFunc>
+auto parallel_map(thread_pool& pool, const std::vector<data_view>& views, TFunc&& func)
+    -> std::vector<typename std::decay<decltype(func(std::declval<const data_view&>()))>::type> {
+    using result_type = typename std::decay<decltype(func(std::declval<const data_view&>()))>::type;
+    static_assert(!std::is_same<result_type, bool>::value,
+                  "results can not be bool, because std::vector<bool> can not be written from several threads");
+
+    std::vector<result_type> results(views.size());
+    pool.for_each_index(views.size(), [&](std::size_t index, std::size_t /*thread*/) {
+        results[index] = func(views[index]);
+    });
+    return results;
+}
+
+/**
+ * Decode all submessages with the specified tag in a message in parallel.
+ * This is collect_submessages() followed by parallel_map(). For a vector
+ * tile use tag 3 to decode the layers.
+ *
+ * @param pool The thread pool.
+ * @param message The message.
+ * @param tag The tag of the submessages.
+ * @param func The function called for each submessage. It is called from
+ *        several threads at the same time.
+ * @returns Vector with the results in the order of the submessages.
+ * @throws Any of the exceptions the pbf_reader can throw if the message is
+ *         invalid or any exception thrown by func.
+ */
+template <typename TFunc>
+auto parallel_decode_submessages(thread_pool& pool, const data_view& message, pbf_tag_type tag, TFunc&& func)
+    -> decltype(parallel_map(pool, std::vector<data_view>{}, std::forward<TFunc>(func))) {
+    return parallel_map(pool, collect_submessages(message, tag), std::forward<TFunc>(func));
+}
+
+/// @cond INTERNAL
+namespace detail {
+
+    // Helper for cutting a range of fields into slices of about the same
+    // number of bytes.
+    class slicer {
+
+        std::vector<data_view> m_slices;
+        const char* m_begin;
+        const char* m_slice_start;
+        std::size_t m_size;
+        std::size_t m_num_slices;
+        std::size_t m_next = 1;
+
+        // Offset where slice number n should end, computed without
+        // overflow.
+        std::size_t target(std::size_t n) const noexcept {
+            return n * (m_size / m_num_slices) + n * (m_size % m_num_slices) / m_num_slices;
+        }
+
+    public:
+
+        slicer(const char* begin, std::size_t size, std::size_t num_slices) :
+            m_begin(begin),
+            m_slice_start(begin),
+            m_size(size),
+            m_num_slices(num_slices == 0 ? 1 : num_slices) {
+            m_slices.reserve(m_num_slices);
+        }
+
+        // Called with the end of each field.
+        void add(const char* field_end) {
+            const auto offset = static_cast<std::size_t>(field_end - m_begin);
+            if (offset < target(m_next)) {
+                return;
+            }
+            m_slices.emplace_back(m_slice_start, static_cast<std::size_t>(field_end - m_slice_start));
+            m_slice_start = field_end;
+            while (m_next < m_num_slices && offset >= target(m_next)) {
+                ++m_next;
+            }
+        }
+
+        std::vector<data_view> finish() {
+            if (m_slice_start != m_begin + m_size) {
+                m_slices.emplace_back(m_slice_start, static_cast<std::size_t>(m_begin + m_size - m_slice_start));
+            }
+            return std::move(m_slices);
+        }
+
+    }; // class slicer
+
+} // end namespace detail
+/// @endcond
+
+/**
+ * Split a message into at most num_slices slices of consecutive fields with
+ * about the same number of bytes. This is done in one pass over the
+ * message skipping over all fields. The slices point into the message, no
+ * data is copied. Each slice is a valid message containing some of the
+ * fields of the original message.
+ *
+ * @param message The message.
+ * @param num_slices The maximum number of slices. There might be fewer if
+ *        the message has fewer fields or if some fields are very large.
+ * @returns The slices in the order of the message.
+ * @throws Any of the exceptions the pbf_reader can throw if the message is
+ *         invalid.
+ */
+inline std::vector<data_view> split_message(const data_view& message, std::size_t num_slices) {
+    detail::slicer slicer{message.data(), message.size(), num_slices};
+    pbf_reader reader{message};
+    while (reader.next()) {
+        reader.skip();
+        slicer.add(reader.data().data());
+    }
+    return slicer.finish();
+}
+
+/**
+ * Split the part of a message containing all fields with the specified tag
+ * into at most num_slices slices with about the same number of bytes using
+ * a prebuilt field_index, so the message doesn't have to be read again.
+ * The slices start with a field with this tag and end after a field with
+ * this tag, but can contain fields with other tags in between, so use
+ * pbf_reader::next(tag) to read them.
+ *
+ * @param index The index of the message.
+ * @param tag The tag of the fields.
+ * @param num_slices The maximum number of slices.
+ * @returns The slices in the order of the message. Empty if there are no
+ *          fields with this tag.
+ */
+inline std::vector<data_view> split_message(const field_index& index, pbf_tag_type tag, std::size_t num_slices) {
+    const auto range = index.find_all(tag);
+    if (range.empty()) {
+        return {};
+    }
+
+    const char* const begin = index.view(*range.begin()).data();
+    const auto last = index.view(*std::prev(range.end()));
+    detail::slicer slicer{begin, static_cast<std::size_t>(last.data() + last.size() - begin), num_slices};
+    for (const auto& e : range) {
+        const auto field = index.view(e);
+        slicer.add(field.data() + field.size());
+    }
+    return slicer.finish();
+}
+
+/**
+ * Process slices of a message in parallel with a separate state for each
+ * thread. For each slice `func(reader, state)` is called with a pbf_reader
+ * for the slice and the state of the thread doing the work. At the end the
+ * states of all threads are returned and can be combined. It is not
+ * defined which slices are processed by which thread, so combining the
+ * states should not depend on the order.
+ *
+ * @code
+ *    protozero::thread_pool pool;
+ *    const auto slices = protozero::split_message(data, 4 * pool.size());
+ *    const auto counts = protozero::parallel_reduce(pool, slices, std::size_t{0},
+ *        [](protozero::pbf_reader& reader, std::size_t& count) {
+ *            while (reader.next(2)) {
+ *                ++count;
+ *                reader.skip();
+ *            }
+ *        });
+ *    const auto total = std::accumulate(counts.begin(), counts.end(), std::size_t{0});
+ * @endcode
+ *
+ * Use a few times more slices than threads, so that threads which are done
+ * early can help with the rest.
+ *
+ * @tparam T The type of the state. Must be copyable and not bool.
+ * @param pool The thread pool.
+ * @param slices The slices of the message, from split_message().
+ * @param init The initial state for each thread.
+ * @param func The function called for each slice.
+ * @returns Vector with the states of all threads (pool.size() elements).
+ * @throws Any exception thrown by func or the pbf_reader. See
+ *         thread_pool::for_each_index().
+ */
+template <typename T, typename TFunc>
+std::vector<T> parallel_reduce(thread_pool& pool, const std::vector<data_view>& slices, const T& init, TFunc&& func) {
+    static_assert(!std::is_same<T, bool>::value,
+                  "state can not be bool, because std::vector<bool> can not be written from several threads");
+
+    std::vector<T> states(pool.size(), init);
+    pool.for_each_index(slices.size(), [&](std::size_t index, std::size_t thread) {
+        // Work on a local copy to avoid false sharing between the states.
+        T state = std::move(states[thread]);
+        pbf_reader reader{slices[index]};
+        func(reader, state);
+        states[thread] = std::move(state);
+    });
+    return states;
+}
+
+/**
+ * Split a message and process the slices in parallel. This is
+ * split_message() with four slices per thread followed by
+ * parallel_reduce().
+ *
+ * @param pool The thread pool.
+ * @param message The message.
+ * @param init The initial state for each thread.
+ * @param func The function called for each slice.
+ * @returns Vector with the states of all threads (pool.size() elements).
+ * @throws Any exception thrown by func or the pbf_reader.
+ */
+template <typename T, typename TFunc>
+std::vector<T> parallel_scan(thread_pool& pool, const data_view& message, const T& init, TFunc&& func) {
+    return parallel_reduce(pool, split_message(message, 4 * pool.size()), init, std::forward<TFunc>(func));
+}
+
+} // end namespace protozero
+
+#endif // PROTOZERO_PARALLEL_HPP
@@ -60,13 +60,19 @@ namespace protozero {
  * integer tag, this template class takes a tag of the template type T.
  *
  * Read the tutorial to understand how this class is used.
+ *
+ * @tparam T Enum type of the tags of the message.
+ * @tparam TPolicy checked_policy (the default) or trusted_policy. See
+ *         basic_pbf_reader.
  */
-template <typename T>
-class pbf_message : public pbf_reader {
+template <typename T, typename TPolicy = checked_policy>
+class pbf_message : public basic_pbf_reader<TPolicy> {
 
     static_assert(std::is_same<pbf_tag_type, typename std::underlying_type<T>::type>::value,
                   "T must be enum with underlying type protozero::pbf_tag_type");
 
+    using reader_type = basic_pbf_reader<TPolicy>;
+
 public:
 
     /// The type of messages this class will read.
@@ -78,7 +84,7 @@ public:
      */
     template <typename... Args>
     pbf_message(Args&&... args) noexcept : // NOLINT(google-explicit-constructor, hicpp-explicit-conversions)
-        pbf_reader{std::forward<Args>(args)...} {
+        reader_type{std::forward<Args>(args)...} {
     }
 
     /**
@@ -97,7 +103,7 @@ public:
      * @post If it returns `true` there is a current field now.
      */
     bool next() {
-        return pbf_reader::next();
+        return reader_type::next();
     }
 
     /**
@@ -129,7 +135,7 @@ public:
      * @post If it returns `true` there is a current field now with the given tag.
      */
     bool next(T next_tag) {
-        return pbf_reader::next(pbf_tag_type(next_tag));
+        return reader_type::next(pbf_tag_type(next_tag));
     }
 
     /**
@@ -161,7 +167,7 @@ public:
      * @post If it returns `true` there is a current field now with the given tag.
      */
     bool next(T next_tag, pbf_wire_type type) {
-        return pbf_reader::next(pbf_tag_type(next_tag), type);
+        return reader_type::next(pbf_tag_type(next_tag), type);
     }
 
     /**
@@ -174,7 +180,7 @@ public:
      * @pre There must be a current field (ie. next() must have returned `true`).
      */
     T tag() const noexcept {
-        return T(pbf_reader::tag());
+        return T(reader_type::tag());
     }
 
 }; // class pbf_message
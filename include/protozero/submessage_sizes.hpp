@@ -0,0 +1,115 @@
+#ifndef PROTOZERO_SUBMESSAGE_SIZES_HPP
+#define PROTOZERO_SUBMESSAGE_SIZES_HPP
+
+/*****************************************************************************
+
+protozero - Minimalistic protocol buffer decoder and encoder in C++.
+
+This file is from https://github.com/mapbox/protozero where you can find more
+documentation.
+
+*****************************************************************************/
+
+/**
+ * @file submessage_sizes.hpp
+ *
+ * @brief Contains the submessage_sizes class.
+ */
+
+#include <protozero/config.hpp>
+#include <protozero/types.hpp>
+
+#include <cstddef>
+#include <vector>
+
+namespace protozero {
+
+/**
+ * Storage for the sizes of all submessages in a message. Used for writing
+ * a message in two passes.
+ *
+ * In the first pass a basic_pbf_writer created with this object records the
+ * size of every submessage in the order the submessages are opened. Usually
+ * this pass writes into a counting_buffer, so no data is actually stored.
+ * After calling start_replay(), a basic_pbf_writer created with this object
+ * uses the recorded sizes to write the exact length of every submessage
+ * directly when it is opened. This way no space has to be reserved for the
+ * length and no data has to be moved when the submessage is closed.
+ *
+ * Both passes must write exactly the same data in the same order.
+ */
+class submessage_sizes {
+
+    // The sizes of all submessages in the order they were opened. A size
+    // of 0 means the submessage was empty or was rolled back.
+    std::vector<pbf_length_type> m_sizes{};
+
+    // The index of the next size to be used when replaying.
+    std::size_t m_next = 0;
+
+    bool m_recording = true;
+
+public:
+
+    /// Create an empty object in recording mode.
+    submessage_sizes() = default;
+
+    /// Is this object in recording mode?
+    bool recording() const noexcept {
+        return m_recording;
+    }
+
+    /// The number of submessage sizes recorded.
+    std::size_t size() const noexcept {
+        return m_sizes.size();
+    }
+
+    /**
+     * Switch to replay mode. Call this after the first pass and before the
+     * second pass. Can be called again to replay the same sizes for writing
+     * the same message once more.
+     */
+    void start_replay() noexcept {
+        m_recording = false;
+        m_next = 0;
+    }
+
+    /**
+     * Remove all recorded sizes and switch back to recording mode, so this
+     * object can be reused for another message.
+     */
+    void clear() noexcept {
+        m_sizes.clear();
+        m_next = 0;
+        m_recording = true;
+    }
+
+/// @cond INTERNAL
+
+    // Do not rely on anything beyond this point
+
+    std::size_t add() {
+        protozero_assert(m_recording);
+        m_sizes.push_back(0);
+        return m_sizes.size() - 1;
+    }
+
+    void set(std::size_t index, pbf_length_type size) {
+        protozero_assert(m_recording);
+        protozero_assert(index < m_sizes.size());
+        m_sizes[index] = size;
+    }
+
+    pbf_length_type next() {
+        protozero_assert(!m_recording);
+        protozero_assert(m_next < m_sizes.size() && "more submessages written than recorded");
+        return m_sizes[m_next++];
+    }
+
+/// @endcond
+
+}; // class submessage_sizes
+
+} // end namespace protozero
+
+#endif // PROTOZERO_SUBMESSAGE_SIZES_HPP
@@ -0,0 +1,350 @@
+#ifndef PROTOZERO_VALIDATE_HPP
+#define PROTOZERO_VALIDATE_HPP
+
+/*****************************************************************************
+
+protozero - Minimalistic protocol buffer decoder and encoder in C++.
+
+This file is from https://github.com/mapbox/protozero where you can find more
+documentation.
+
+*****************************************************************************/
+
+/**
+ * @file validate.hpp
+ *
+ * @brief Contains functions for checking untrusted data without throwing
+ *        exceptions.
+ */
+
+#include <protozero/bulk_varint.hpp>
+#include <protozero/config.hpp>
+#include <protozero/data_view.hpp>
+#include <protozero/types.hpp>
+#include <protozero/varint.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace protozero {
+
+/**
+ * The kind of problem found by validate(). Apart from `too_deep` each
+ * value corresponds to the exception the pbf_reader would throw when
+ * reading the data.
+ */
+enum class validation_error : uint8_t {
+    none              = 0, ///< Data is valid
+    end_of_buffer     = 1, ///< See end_of_buffer_exception
+    varint_too_long   = 2, ///< See varint_too_long_exception
+    invalid_tag       = 3, ///< See invalid_tag_exception
+    unknown_wire_type = 4, ///< See unknown_pbf_wire_type_exception
+    too_deep          = 5  ///< Submessages are nested too deeply
+};
+
+/**
+ * The result of validate(). Evaluates to `true` in a boolean context if
+ * the data is valid.
+ */
+class validation_result {
+
+    std::size_t m_offset = 0;
+    validation_error m_error = validation_error::none;
+
+public:
+
+    /// Create a result for valid data.
+    constexpr validation_result() noexcept = default;
+
+    /// Create a result with the specified error at the specified offset.
+    constexpr validation_result(validation_error error, std::size_t offset) noexcept :
+        m_offset(offset),
+        m_error(error) {
+    }
+
+    /// The kind of problem found.
+    constexpr validation_error error() const noexcept {
+        return m_error;
+    }
+
+    /**
+     * The offset (from the beginning of the data) of the field (or the
+     * varint in a packed repeated field) in which the problem was found.
+     * Always 0 if the data is valid.
+     */
+    constexpr std::size_t offset() const noexcept {
+        return m_offset;
+    }
+
+    /// Is the data valid?
+    constexpr bool ok() const noexcept {
+        return m_error == validation_error::none;
+    }
+
+    /// Is the data valid?
+    constexpr explicit operator bool() const noexcept {
+        return ok();
+    }
+
+}; // class validation_result
+
+/// @cond INTERNAL
+namespace detail {
+
+    // Like decode_varint(), but reports errors instead of throwing. Accepts
+    // and rejects exactly the same input.
+    inline validation_error scan_varint(const char** data, const char* end, uint64_t* value) noexcept {
+        const char* p = *data;
+
+        // Fast path for the most common case of a one-byte varint.
+        if (p != end && static_cast<uint8_t>(*p) < 0x80U) {
+            *value = static_cast<uint8_t>(*p);
+            *data = p + 1;
+            return validation_error::none;
+        }
+
+        uint64_t val = 0;
+        for (unsigned int shift = 0; shift < 7U * max_varint_length; shift += 7U) {
+            if (p == end) {
+                return validation_error::end_of_buffer;
+            }
+            const auto b = static_cast<uint8_t>(*p++);
+            val |= static_cast<uint64_t>(b & 0x7fU) << shift;
+            if (b < 0x80U) {
+                *data = p;
+                *value = val;
+                return validation_error::none;
+            }
+        }
+        return validation_error::varint_too_long;
+    }
+
+    // Check one field starting at *data. On success *data points to the
+    // next field. For length-delimited fields *size is set to the length,
+    // otherwise it is not changed.
+    inline validation_error scan_field(const char** data, const char* end, pbf_tag_type* tag, pbf_wire_type* type, std::size_t* size) noexcept {
+        uint64_t value = 0;
+        auto error = scan_varint(data, end, &value);
+        if (error != validation_error::none) {
+            return error;
+        }
+
+        // Same truncation to 32 bit as in pbf_reader::next().
+        const auto key = static_cast<uint32_t>(value);
+        *tag = key >> 3U;
+        if (*tag == 0 || (*tag >= 19000 && *tag <= 19999)) {
+            return validation_error::invalid_tag;
+        }
+
+        std::size_t skip = 0;
+        *type = static_cast<pbf_wire_type>(key & 0x07U);
+        switch (*type) {
+            case pbf_wire_type::varint:
+                return scan_varint(data, end, &value);
+            case pbf_wire_type::fixed64:
+                skip = 8;
+                break;
+            case pbf_wire_type::length_delimited:
+                error = scan_varint(data, end, &value);
+                if (error != validation_error::none) {
+                    return error;
+                }
+                // Same truncation as in pbf_reader::get_length().
+                skip = static_cast<pbf_length_type>(value);
+                *size = skip;
+                break;
+            case pbf_wire_type::fixed32:
+                skip = 4;
+                break;
+            default:
+                return validation_error::unknown_wire_type;
+        }
+
+        if (static_cast<std::size_t>(end - *data) < skip) {
+            return validation_error::end_of_buffer;
+        }
+        if (*type != pbf_wire_type::length_delimited) {
+            *data += skip;
+        }
+        return validation_error::none;
+    }
+
+} // end namespace detail
+/// @endcond
+
+/**
+ * Check that all fields of a message can be read with a pbf_reader without
+ * an exception. The contents of length-delimited fields are not checked.
+ *
+ * This is much cheaper than catching an exception if you expect some data
+ * to be invalid, for instance when guessing whether some bytes contain a
+ * message.
+ *
+ * @param data The message.
+ * @returns The result, which evaluates to `true` if the data is valid.
+ */
+inline validation_result validate(const data_view& data) noexcept {
+    const char* const begin = data.data();
+    const char* const end = begin + data.size();
+    const char* p = begin;
+
+    while (p != end) {
+        const char* const field = p;
+        pbf_tag_type tag = 0;
+        pbf_wire_type type = pbf_wire_type::unknown;
+        std::size_t size = 0;
+        const auto error = detail::scan_field(&p, end, &tag, &type, &size);
+        if (error != validation_error::none) {
+            return {error, static_cast<std::size_t>(field - begin)};
+        }
+        if (type == pbf_wire_type::length_delimited) {
+            p += size;
+        }
+    }
+
+    return {};
+}
+
+/**
+ * Check a message and its submessages in one pass, so that they can be
+ * read with a pbf_reader without an exception.
+ *
+ * The wire format doesn't say which length-delimited fields contain
+ * submessages (and not strings, bytes, or packed repeated fields), so the
+ * predicate is asked for every length-delimited field. It gets the path of
+ * tags from the outermost message to the field:
+ *
+ * @code
+ *    // Check a vector tile: layers (tag 3) contain features (tag 2)
+ *    // and values (tag 4).
+ *    const auto result = protozero::validate(data, 2,
+ *        [](const protozero::pbf_tag_type* path, std::size_t depth) {
+ *            return path[0] == 3 && (depth == 1 || (depth == 2 && (path[1] == 2 || path[1] == 4)));
+ *        });
+ *    if (!result) {
+ *        std::cerr << "invalid tile at offset " << result.offset() << '\n';
+ *    }
+ * @endcode
+ *
+ * Submessages are checked with an explicit stack in the same pass over the
+ * data as the enclosing message, there is no recursion.
+ *
+ * @param data The message.
+ * @param max_depth Maximum nesting depth of submessages. If the predicate
+ *        returns `true` for a path longer than this, the result is a
+ *        validation_error::too_deep error.
+ * @param is_message Predicate called as
+ *        `bool is_message(const pbf_tag_type* path, std::size_t depth)`
+ *        for every length-delimited field. Should return `true` if the field
+ *        with the specified path contains a submessage.
+ * @returns The result, which evaluates to `true` if the data is valid.
+ *          If the predicate throws, the exception is propagated.
+ */
+template <typename TPredicate>
+validation_result validate(const data_view& data, std::size_t max_depth, TPredicate&& is_message) {
+    const char* const begin = data.data();
+    const char* p = begin;
+
+    // End of the message at each level and the tags of the fields
+    // containing them.
+    std::vector<const char*> ends;
+    std::vector<pbf_tag_type> path;
+    ends.push_back(begin + data.size());
+
+    while (true) {
+        while (p == ends.back()) {
+            ends.pop_back();
+            if (ends.empty()) {
+                return {};
+            }
+            path.pop_back();
+        }
+
+        const char* const field = p;
+        pbf_tag_type tag = 0;
+        pbf_wire_type type = pbf_wire_type::unknown;
+        std::size_t size = 0;
+        const auto error = detail::scan_field(&p, ends.back(), &tag, &type, &size);
+        if (error != validation_error::none) {
+            return {error, static_cast<std::size_t>(field - begin)};
+        }
+
+        if (type == pbf_wire_type::length_delimited) {
+            path.push_back(tag);
+            if (is_message(path.data(), path.size())) {
+                if (path.size() > max_depth) {
+                    return {validation_error::too_deep, static_cast<std::size_t>(field - begin)};
+                }
+                ends.push_back(p + size);
+            } else {
+                path.pop_back();
+                p += size;
+            }
+        }
+    }
+}
+
+/**
+ * Check that the data of a packed repeated varint field (for instance
+ * from pbf_reader::get_view()) can be decoded without an exception.
+ *
+ * Blocks of bytes are checked at once using SSE2 or AVX2 if available.
+ *
+ * @param data The data of the field.
+ * @returns The result, which evaluates to `true` if the data is valid.
+ */
+inline validation_result validate_packed_varint(const data_view& data) noexcept {
+    const char* const begin = data.data();
+    const char* const end = begin + data.size();
+    const char* p = begin;
+
+    // Number of continuation bytes directly before p.
+    std::size_t run = 0;
+
+    // Track a byte given its continuation bit, returns false if it is the
+    // last byte of a varint that is too long.
+    const auto check = [&run](bool continuation) noexcept {
+        if (!continuation) {
+            run = 0;
+            return true;
+        }
+        return ++run < max_varint_length;
+    };
+
+    const auto too_long = [begin](const char* pos) noexcept {
+        return validation_result{validation_error::varint_too_long,
+                                 static_cast<std::size_t>(pos - begin) + 1 - max_varint_length};
+    };
+
+    while (end - p >= detail::varint_block_size) {
+        const uint32_t bits = detail::continuation_bits(p);
+        if (bits == 0) {
+            // Common case for small values: all varints are one byte.
+            run = 0;
+        } else {
+            for (int n = 0; n < detail::varint_block_size; ++n) {
+                if (!check(((bits >> static_cast<unsigned int>(n)) & 1U) != 0)) {
+                    return too_long(p + n);
+                }
+            }
+        }
+        p += detail::varint_block_size;
+    }
+
+    for (; p != end; ++p) {
+        if (!check((static_cast<uint8_t>(*p) & 0x80U) != 0)) {
+            return too_long(p);
+        }
+    }
+
+    if (run > 0) {
+        return {validation_error::end_of_buffer, static_cast<std::size_t>(end - begin) - run};
+    }
+
+    return {};
+}
+
+} // end namespace protozero
+
+#endif // PROTOZERO_VALIDATE_HPP
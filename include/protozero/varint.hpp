@@ -16,9 +16,15 @@ documentation.
  * @brief Contains low-level varint and zigzag encoding and decoding functions.
  */
 
+#include <protozero/config.hpp>
 #include <protozero/exception.hpp>
 
+#ifdef PROTOZERO_USE_BMI2
+# include <immintrin.h>
+#endif
+
 #include <cstdint>
+#include <cstring>
 
 namespace protozero {
 
@@ -29,6 +35,29 @@ constexpr const int8_t max_varint_length = sizeof(uint64_t) * 8 / 7 + 1;
 
 namespace detail {
 
+#ifdef PROTOZERO_USE_BMI2
+    // Decode a varint of up to 8 bytes without any data-dependent branches.
+    // Loads 8 bytes, finds the first byte without continuation bit and
+    // gathers the 7 bit groups of all bytes up to that one with pext. There
+    // must be at least 8 bytes available at data. Returns false without
+    // changing anything if the varint is longer than 8 bytes.
+    inline bool decode_varint_bmi2(const char** data, uint64_t* value) noexcept {
+        uint64_t word;
+        std::memcpy(&word, *data, sizeof(word));
+
+        const uint64_t last_bytes = ~word & 0x8080808080808080ULL;
+        if (last_bytes == 0) {
+            return false;
+        }
+
+        // Position of the high bit of the last byte of the varint.
+        const auto last_bit = static_cast<unsigned int>(__builtin_ctzll(last_bytes));
+        *value = _pext_u64(word, _bzhi_u64(0x7f7f7f7f7f7f7f7fULL, last_bit));
+        *data += last_bit / 8U + 1U;
+        return true;
+    }
+#endif
+
     // from https://github.com/facebook/folly/blob/master/folly/Varint.h
     inline uint64_t decode_varint_impl(const char** data, const char* end) {
         const auto begin = reinterpret_cast<const int8_t*>(*data);
@@ -37,6 +66,11 @@ namespace detail {
         uint64_t val = 0;
 
         if (iend - begin >= max_varint_length) {  // fast path
+#ifdef PROTOZERO_USE_BMI2
+            if (decode_varint_bmi2(data, &val)) {
+                return val;
+            }
+#endif
             do {
                 int64_t b;
                 b = *p++; val  = ((uint64_t(b) & 0x7fU)       ); if (b >= 0) { break; }
@@ -67,6 +101,42 @@ namespace detail {
         return val;
     }
 
+    // Decode a varint without any checks. The data must contain a complete
+    // varint that is not too long, for instance because it has been checked
+    // with validate() before. Used by the basic_pbf_reader with the
+    // trusted_policy.
+    inline uint64_t decode_varint_trusted(const char** data) noexcept {
+        const auto* p = reinterpret_cast<const int8_t*>(*data);
+        uint64_t val = 0;
+
+        do {
+            int64_t b;
+            b = *p++; val  = ((uint64_t(b) & 0x7fU)       ); if (b >= 0) { break; }
+            b = *p++; val |= ((uint64_t(b) & 0x7fU) <<  7U); if (b >= 0) { break; }
+            b = *p++; val |= ((uint64_t(b) & 0x7fU) << 14U); if (b >= 0) { break; }
+            b = *p++; val |= ((uint64_t(b) & 0x7fU) << 21U); if (b >= 0) { break; }
+            b = *p++; val |= ((uint64_t(b) & 0x7fU) << 28U); if (b >= 0) { break; }
+            b = *p++; val |= ((uint64_t(b) & 0x7fU) << 35U); if (b >= 0) { break; }
+            b = *p++; val |= ((uint64_t(b) & 0x7fU) << 42U); if (b >= 0) { break; }
+            b = *p++; val |= ((uint64_t(b) & 0x7fU) << 49U); if (b >= 0) { break; }
+            b = *p++; val |= ((uint64_t(b) & 0x7fU) << 56U); if (b >= 0) { break; }
+            b = *p++; val |= ((uint64_t(b) & 0x01U) << 63U);
+        } while (false);
+
+        *data = reinterpret_cast<const char*>(p);
+        return val;
+    }
+
+    // Skip a varint without any checks. Same preconditions as for
+    // decode_varint_trusted().
+    inline void skip_varint_trusted(const char** data) noexcept {
+        const auto* p = reinterpret_cast<const int8_t*>(*data);
+        while (*p < 0) {
+            ++p;
+        }
+        *data = reinterpret_cast<const char*>(p + 1);
+    }
+
 } // end namespace detail
 
 /**
@@ -162,6 +232,12 @@ inline int write_varint(T data, uint64_t value) {
  * @returns the number of bytes the varint would have if we created it.
  */
 inline int length_of_varint(uint64_t value) noexcept {
+#ifdef PROTOZERO_USE_BUILTIN_CLZ
+    // Number of significant bits divided by 7 and rounded up, computed
+    // without a loop or division.
+    const auto bits = static_cast<unsigned int>(64 - __builtin_clzll(value | 1U));
+    return static_cast<int>((bits * 9U + 64U) / 64U);
+#else
     int n = 1;
 
     while (value >= 0x80U) {
@@ -170,6 +246,7 @@ inline int length_of_varint(uint64_t value) noexcept {
     }
 
     return n;
+#endif
 }
 
 /**
@@ -0,0 +1,249 @@
+#ifndef PROTOZERO_VECTOR_TILE_GEOMETRY_HPP
+#define PROTOZERO_VECTOR_TILE_GEOMETRY_HPP
+
+/*****************************************************************************
+
+protozero - Minimalistic protocol buffer decoder and encoder in C++.
+
+This file is from https://github.com/mapbox/protozero where you can find more
+documentation.
+
+*****************************************************************************/
+
+/**
+ * @file vector_tile_geometry.hpp
+ *
+ * @brief Contains the geometry_decoder class for decoding the geometry of
+ *        vector tile features.
+ */
+
+#include <protozero/config.hpp>
+#include <protozero/exception.hpp>
+#include <protozero/iterators.hpp>
+#include <protozero/varint.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace protozero {
+
+/**
+ * A point of a vector tile geometry in tile coordinates.
+ */
+struct geometry_point {
+    /// X coordinate
+    int32_t x;
+
+    /// Y coordinate
+    int32_t y;
+};
+
+/// Two points are equal if both coordinates are equal.
+inline constexpr bool operator==(const geometry_point& lhs, const geometry_point& rhs) noexcept {
+    return lhs.x == rhs.x && lhs.y == rhs.y;
+}
+
+/// Two points are not equal if any of the coordinates are different.
+inline constexpr bool operator!=(const geometry_point& lhs, const geometry_point& rhs) noexcept {
+    return !(lhs == rhs);
+}
+
+/**
+ * The commands used in vector tile geometries.
+ */
+enum class geometry_command : uint32_t {
+    move_to    = 1, ///< Start a new part at the given point(s)
+    line_to    = 2, ///< Add the given points to the current part
+    close_path = 7  ///< Close the current ring
+};
+
+/**
+ * Decodes the geometry of a feature in a vector tile as described in the
+ * vector tile specification
+ * (https://github.com/mapbox/vector-tile-spec/tree/master/2.1). The
+ * geometry is a packed repeated uint32 field (tag 4 in the Feature message)
+ * containing command integers, each followed by the zigzag-encoded deltas
+ * of the points for that command.
+ *
+ * The points of each command are decoded in one tight loop and handed to
+ * the handler (or written to the point buffer) in one batch. The decoder
+ * keeps its buffer between calls, so if you use one decoder for all
+ * features there are no memory allocations after the first few features.
+ *
+ * The decoder doesn't check whether the commands make sense for the
+ * geometry type of the feature (for instance a MoveTo with more than one
+ * point in a linestring), it only checks that they can be decoded.
+ */
+class geometry_decoder {
+
+    std::vector<geometry_point> m_points;
+
+    const char* m_data = nullptr;
+    const char* m_end = nullptr;
+
+    // The cursor, unsigned so that it wraps around on overflow.
+    uint32_t m_x = 0;
+    uint32_t m_y = 0;
+
+    uint32_t next_param() {
+        if (m_data == m_end) {
+            throw invalid_geometry_exception{};
+        }
+        return static_cast<uint32_t>(decode_varint(&m_data, m_end));
+    }
+
+    // Decode count points from the parameters of a command into out.
+    void decode_points(std::size_t count, geometry_point* out) {
+        uint32_t x = m_x;
+        uint32_t y = m_y;
+        for (std::size_t n = 0; n < count; ++n) {
+            x += static_cast<uint32_t>(decode_zigzag32(next_param()));
+            y += static_cast<uint32_t>(decode_zigzag32(next_param()));
+            out[n].x = static_cast<int32_t>(x);
+            out[n].y = static_cast<int32_t>(y);
+        }
+        m_x = x;
+        m_y = y;
+    }
+
+    // Call func(command, count) for each command. The function has to
+    // decode the count points of MoveTo and LineTo commands with
+    // decode_points(). For ClosePath the count is 0. The first command
+    // must be a MoveTo.
+    template <typename TFunc>
+    void decode_commands(const iterator_range<const_varint_iterator<uint32_t>>& geometry, TFunc&& func) {
+        m_data = geometry.begin().data();
+        m_end = geometry.end().data();
+        m_x = 0;
+        m_y = 0;
+
+        bool seen_move_to = false;
+        while (m_data != m_end) {
+            const auto value = static_cast<uint32_t>(decode_varint(&m_data, m_end));
+            const auto command = static_cast<geometry_command>(value & 0x7U);
+            const std::size_t count = value >> 3U;
+            if (command == geometry_command::move_to) {
+                seen_move_to = true;
+            } else if (!seen_move_to) {
+                throw invalid_geometry_exception{};
+            }
+            switch (command) {
+                case geometry_command::move_to:
+                case geometry_command::line_to:
+                    // Each point needs at least two bytes.
+                    if (count == 0 || count > static_cast<std::size_t>(m_end - m_data) / 2) {
+                        throw invalid_geometry_exception{};
+                    }
+                    func(command, count);
+                    break;
+                case geometry_command::close_path:
+                    if (count != 1) {
+                        throw invalid_geometry_exception{};
+                    }
+                    func(command, 0);
+                    break;
+                default:
+                    throw invalid_geometry_exception{};
+            }
+        }
+    }
+
+public:
+
+    /**
+     * Decode a geometry and call the handler for each command. The handler
+     * must have these member functions:
+     *
+     * @code
+     *    // Called for each MoveTo command. Usually count is 1, only
+     *    // multipoints have MoveTo commands with more points.
+     *    void move_to(const protozero::geometry_point* points, std::size_t count);
+     *
+     *    // Called for each LineTo command.
+     *    void line_to(const protozero::geometry_point* points, std::size_t count);
+     *
+     *    // Called for each ClosePath command.
+     *    void close_path();
+     * @endcode
+     *
+     * The points are only valid until the handler function returns.
+     *
+     * @code
+     *    protozero::geometry_decoder decoder;
+     *    while (feature.next(4)) {
+     *        decoder.decode(feature.get_packed_uint32(), my_handler);
+     *    }
+     * @endcode
+     *
+     * @param geometry The range of the geometry field as returned by
+     *        pbf_reader::get_packed_uint32().
+     * @param handler The handler.
+     * @throws invalid_geometry_exception if the geometry contains an unknown
+     *         command or a command with the wrong number of parameters or
+     *         if it doesn't start with a MoveTo.
+     * @throws varint_too_long_exception or end_of_buffer_exception if the
+     *         packed field is invalid.
+     * @throws Any exception thrown by the handler.
+     */
+    template <typename THandler>
+    void decode(const iterator_range<const_varint_iterator<uint32_t>>& geometry, THandler&& handler) {
+        decode_commands(geometry, [this, &handler](geometry_command command, std::size_t count) {
+            if (command == geometry_command::close_path) {
+                handler.close_path();
+                return;
+            }
+            if (m_points.size() < count) {
+                m_points.resize(count);
+            }
+            decode_points(count, m_points.data());
+            if (command == geometry_command::move_to) {
+                handler.move_to(m_points.data(), count);
+            } else {
+                handler.line_to(m_points.data(), count);
+            }
+        });
+    }
+
+    /**
+     * Decode a geometry into a buffer of points. Each MoveTo command starts
+     * a new part (a linestring, ring, or the points of a multipoint). The
+     * index of the first point of each part is stored in part_starts.
+     * ClosePath commands don't add a point. Both vectors are cleared first,
+     * so they can be reused for all features without allocating memory.
+     *
+     * @param geometry The range of the geometry field as returned by
+     *        pbf_reader::get_packed_uint32().
+     * @param points The vector the points are written to.
+     * @param part_starts The vector the indexes of the first point of each
+     *        part are written to.
+     * @throws invalid_geometry_exception if the geometry contains an unknown
+     *         command or a command with the wrong number of parameters or
+     *         if it doesn't start with a MoveTo.
+     * @throws varint_too_long_exception or end_of_buffer_exception if the
+     *         packed field is invalid.
+     */
+    void decode(const iterator_range<const_varint_iterator<uint32_t>>& geometry,
+                std::vector<geometry_point>& points,
+                std::vector<std::size_t>& part_starts) {
+        points.clear();
+        part_starts.clear();
+        // Every point needs at least two bytes.
+        points.reserve(static_cast<std::size_t>(geometry.end().data() - geometry.begin().data()) / 2);
+        decode_commands(geometry, [this, &points, &part_starts](geometry_command command, std::size_t count) {
+            if (command == geometry_command::move_to) {
+                part_starts.push_back(points.size());
+            }
+            if (count > 0) {
+                const auto size = points.size();
+                points.resize(size + count);
+                decode_points(count, points.data() + size);
+            }
+        });
+    }
+
+}; // class geometry_decoder
+
+} // end namespace protozero
+
+#endif // PROTOZERO_VECTOR_TILE_GEOMETRY_HPP
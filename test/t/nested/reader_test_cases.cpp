@@ -125,6 +125,35 @@ TEST_CASE("write nested message fields") {
     check(message);
 }
 
+TEST_CASE("write nested message fields with padded lengths") {
+    std::string buffer_test;
+    protozero::pbf_writer pbf_test{buffer_test, protozero::submessage_length_encoding::padded};
+    REQUIRE(pbf_test.length_encoding() == protozero::submessage_length_encoding::padded);
+
+    {
+        protozero::pbf_writer pbf_sub{pbf_test, 1};
+        REQUIRE(pbf_sub.length_encoding() == protozero::submessage_length_encoding::padded);
+        {
+            protozero::pbf_writer pbf_subsub{pbf_sub, 1};
+            pbf_subsub.add_string(1, "foobar");
+            pbf_subsub.add_int32(2, 99);
+        }
+        {
+            protozero::pbf_writer pbf_empty{pbf_sub, 3};
+        }
+        pbf_sub.add_int32(2, 88);
+    }
+
+    pbf_test.add_int32(2, 77);
+
+    // header of sub and subsub each have a 5 byte length
+    REQUIRE(buffer_test.size() == 1 + 5 + 1 + 5 + 8 + 2 + 2 + 2);
+    REQUIRE(buffer_test.substr(0, 6) == std::string("\x0a\x92\x80\x80\x80\x00", 6));
+
+    protozero::pbf_reader message{buffer_test};
+    check(message);
+}
+
 TEST_CASE("write nested message fields - no message") {
     std::string buffer_test;
     protozero::pbf_writer pbf_test{buffer_test};
@@ -51,3 +51,28 @@ TEST_CASE("write tags") {
     }
 }
 
+
+TEST_CASE("write tags known at compile time") {
+    std::string buffer;
+    protozero::pbf_writer pw{buffer};
+
+    SECTION("tag 1") {
+        pw.add_int32<1>(333L);
+        REQUIRE(buffer == load_data("tags/data-tag-1"));
+    }
+
+    SECTION("tag 200") {
+        pw.add_int32<200>(333L);
+        REQUIRE(buffer == load_data("tags/data-tag-200"));
+    }
+
+    SECTION("tag 200000") {
+        pw.add_int32<200000>(333L);
+        REQUIRE(buffer == load_data("tags/data-tag-200000"));
+    }
+
+    SECTION("tag max") {
+        pw.add_int32<(1UL << 29U) - 1U>(333L);
+        REQUIRE(buffer == load_data("tags/data-tag-max"));
+    }
+}
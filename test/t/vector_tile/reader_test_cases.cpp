@@ -1,6 +1,9 @@
 
 #include <test.hpp>
 
+#include <protozero/vector_tile_geometry.hpp>
+
+#include <cstddef>
 #include <string>
 #include <vector>
 
@@ -153,3 +156,69 @@ TEST_CASE("reading vector tiles") {
     }
 }
 
+namespace {
+
+    // Counts points and checks they are in the same order as in the
+    // point buffer.
+    struct checking_handler {
+        const std::vector<protozero::geometry_point>* points;
+        std::size_t count = 0;
+
+        explicit checking_handler(const std::vector<protozero::geometry_point>* p) :
+            points(p) {
+        }
+
+        void check(const protozero::geometry_point* begin, std::size_t size) {
+            for (std::size_t n = 0; n < size; ++n) {
+                REQUIRE(begin[n] == (*points)[count++]);
+            }
+        }
+
+        void move_to(const protozero::geometry_point* begin, std::size_t size) {
+            check(begin, size);
+        }
+
+        void line_to(const protozero::geometry_point* begin, std::size_t size) {
+            check(begin, size);
+        }
+
+        void close_path() {
+        }
+    };
+
+} // anonymous namespace
+
+TEST_CASE("decoding geometries of vector tile") {
+    const std::string buffer = load_data("vector_tile/data.vector");
+    protozero::pbf_reader item{buffer};
+
+    protozero::geometry_decoder decoder;
+    std::vector<protozero::geometry_point> points;
+    std::vector<std::size_t> part_starts;
+    std::size_t num_features = 0;
+    std::size_t num_points = 0;
+
+    while (item.next(3)) { // repeated message Layer
+        protozero::pbf_reader layer{item.get_message()};
+        while (layer.next(2)) { // repeated Feature
+            protozero::pbf_reader feature{layer.get_message()};
+            while (feature.next(4)) { // packed uint32 geometry
+                const auto geometry = feature.get_packed_uint32();
+                decoder.decode(geometry, points, part_starts);
+                REQUIRE_FALSE(points.empty());
+                REQUIRE(part_starts.front() == 0);
+                REQUIRE(part_starts.back() < points.size());
+
+                checking_handler handler{&points};
+                decoder.decode(geometry, handler);
+                REQUIRE(handler.count == points.size());
+
+                ++num_features;
+                num_points += points.size();
+            }
+        }
+    }
+
+    REQUIRE(num_features > 1000);
+    REQUIRE(num_points > num_features);
+}
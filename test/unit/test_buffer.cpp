@@ -0,0 +1,443 @@
+
+#include <test.hpp>
+
+#include <protozero/buffer_counting.hpp>
+#include <protozero/buffer_fixed.hpp>
+#include <protozero/buffer_segmented.hpp>
+#include <protozero/buffer_small.hpp>
+#include <protozero/buffer_string.hpp>
+#include <protozero/buffer_vector.hpp>
+
+#include <array>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Writes the same message into any kind of buffer.
+template <typename TBuffer>
+static void write_test_message(TBuffer& buffer) {
+    protozero::basic_pbf_writer<TBuffer> pw{buffer};
+    pw.add_fixed32(1, 42);
+    pw.add_string(2, "foobar");
+    {
+        protozero::basic_pbf_writer<TBuffer> sub{pw, 3};
+        sub.add_sint64(1, -17);
+        const std::array<uint32_t, 4> values = {{1, 300, 70000, 3}};
+        sub.add_packed_uint32(2, values.begin(), values.end());
+        {
+            protozero::basic_pbf_writer<TBuffer> subsub{sub, 3};
+            subsub.add_bool(1, true);
+        }
+    }
+    {
+        protozero::basic_pbf_writer<TBuffer> sub{pw, 4};
+        sub.add_double(1, 1.5);
+        sub.rollback();
+    }
+    {
+        protozero::detail::packed_field_svarint<TBuffer, int32_t> field{pw, 5};
+        field.add_element(-1);
+        field.add_element(1000);
+    }
+    pw.add_int32(6, 123);
+    pw.add_uint64(7, std::numeric_limits<uint64_t>::max());
+}
+
+static std::string expected_test_message() {
+    std::string buffer;
+    write_test_message(buffer);
+    return buffer;
+}
+
+TEST_CASE("Write to std::string and read back") {
+    const std::string buffer = expected_test_message();
+
+    protozero::pbf_reader item{buffer};
+    REQUIRE(item.next(1));
+    REQUIRE(item.get_fixed32() == 42);
+    REQUIRE(item.next(2));
+    REQUIRE(item.get_string() == "foobar");
+    REQUIRE(item.next(3));
+    item.skip();
+    REQUIRE(item.next());
+    REQUIRE(item.tag() == 5);
+    item.skip();
+    REQUIRE(item.next(6));
+    REQUIRE(item.get_int32() == 123);
+    REQUIRE(item.next(7));
+    REQUIRE(item.get_uint64() == std::numeric_limits<uint64_t>::max());
+    REQUIRE_FALSE(item.next());
+}
+
+TEST_CASE("Write to std::vector<char>") {
+    std::vector<char> buffer;
+    write_test_message(buffer);
+
+    REQUIRE(std::string(buffer.data(), buffer.size()) == expected_test_message());
+}
+
+TEST_CASE("Write to std::vector<char> appends to existing data") {
+    std::vector<char> buffer = {'a', 'b', 'c'};
+    write_test_message(buffer);
+
+    REQUIRE(std::string(buffer.data(), buffer.size()) == "abc" + expected_test_message());
+}
+
+namespace {
+
+    // Allocator making a vector type without its own buffer customization.
+    template <typename T>
+    struct test_allocator : public std::allocator<T> {
+        template <typename U>
+        struct rebind {
+            using other = test_allocator<U>;
+        };
+
+        test_allocator() = default;
+
+        template <typename U>
+        test_allocator(const test_allocator<U>& /*other*/) noexcept {
+        }
+    };
+
+} // anonymous namespace
+
+TEST_CASE("Write to container using the default buffer customization") {
+    std::vector<char, test_allocator<char>> buffer;
+    write_test_message(buffer);
+
+    REQUIRE(std::string(buffer.begin(), buffer.end()) == expected_test_message());
+}
+
+TEST_CASE("Write to fixed size buffer") {
+    std::array<char, 1024> data;
+    protozero::fixed_size_buffer_adaptor buffer{data};
+    REQUIRE(buffer.capacity() == data.size());
+
+    write_test_message(buffer);
+
+    REQUIRE(std::string(buffer.data(), buffer.size()) == expected_test_message());
+    REQUIRE(std::string(buffer.begin(), buffer.end()) == expected_test_message());
+}
+
+TEST_CASE("Write to fixed size buffer which is too small") {
+    const std::size_t size = expected_test_message().size();
+
+    for (std::size_t capacity = 0; capacity < size; ++capacity) {
+        std::vector<char> data(capacity);
+        protozero::fixed_size_buffer_adaptor buffer{data.data(), data.size()};
+        REQUIRE_THROWS_AS(write_test_message(buffer), const std::length_error&);
+        REQUIRE(buffer.size() <= capacity);
+    }
+}
+
+TEST_CASE("Write to fixed size buffer needing room for submessage lengths") {
+    // Open submessages temporarily reserve 5 bytes for their length field.
+    // The test message has up to two nested submessages open at once.
+    const std::size_t size = expected_test_message().size();
+    std::vector<char> data(size + 2 * 5);
+
+    protozero::fixed_size_buffer_adaptor buffer{data.data(), data.size()};
+    write_test_message(buffer);
+    REQUIRE(std::string(buffer.data(), buffer.size()) == expected_test_message());
+}
+
+TEST_CASE("Write to fixed size buffer using an array") {
+    char data[1024];
+    protozero::fixed_size_buffer_adaptor buffer{data};
+    REQUIRE(buffer.capacity() == sizeof(data));
+
+    write_test_message(buffer);
+
+    REQUIRE(std::string(buffer.data(), buffer.size()) == expected_test_message());
+}
+
+TEST_CASE("Write to small buffer") {
+    protozero::small_buffer<256> buffer;
+    REQUIRE(buffer.empty());
+    REQUIRE(buffer.capacity() == 256);
+
+    write_test_message(buffer);
+
+    REQUIRE_FALSE(buffer.on_heap());
+    REQUIRE(buffer.capacity() == 256);
+    REQUIRE(buffer.to_string() == expected_test_message());
+    REQUIRE(std::string(buffer.begin(), buffer.end()) == expected_test_message());
+
+    buffer.clear();
+    REQUIRE(buffer.empty());
+    write_test_message(buffer);
+    REQUIRE(buffer.to_string() == expected_test_message());
+}
+
+TEST_CASE("Write to small buffer overflowing to the heap") {
+    const std::string expected = expected_test_message();
+
+    SECTION("one byte") {
+        protozero::small_buffer<1> buffer;
+        write_test_message(buffer);
+        REQUIRE(buffer.on_heap());
+        REQUIRE(buffer.to_string() == expected);
+    }
+
+    SECTION("while writing submessages") {
+        protozero::small_buffer<16> buffer;
+        write_test_message(buffer);
+        REQUIRE(buffer.on_heap());
+        REQUIRE(buffer.capacity() >= buffer.size());
+        REQUIRE(buffer.to_string() == expected);
+    }
+
+    SECTION("large field") {
+        protozero::small_buffer<64> buffer;
+        protozero::basic_pbf_writer<protozero::small_buffer<64>> pw{buffer};
+        const std::string value(1000, 'x');
+        pw.add_string(1, value);
+        REQUIRE(buffer.on_heap());
+
+        protozero::pbf_reader reader{buffer.data(), buffer.size()};
+        REQUIRE(reader.next(1));
+        REQUIRE(reader.get_string() == value);
+        REQUIRE_FALSE(reader.next());
+    }
+
+    SECTION("reserve") {
+        protozero::small_buffer<64> buffer;
+        protozero::basic_pbf_writer<protozero::small_buffer<64>> pw{buffer};
+        pw.reserve(1000);
+        REQUIRE(buffer.on_heap());
+        REQUIRE(buffer.capacity() >= 1000);
+        REQUIRE(buffer.empty());
+    }
+}
+
+TEST_CASE("Roll back submessage in small buffer after it moved to the heap") {
+    protozero::small_buffer<16> buffer;
+    protozero::basic_pbf_writer<protozero::small_buffer<16>> pw{buffer};
+    pw.add_uint32(1, 17);
+    const auto size = buffer.size();
+    {
+        protozero::basic_pbf_writer<protozero::small_buffer<16>> sub{pw, 2};
+        sub.add_string(1, std::string(100, 'y'));
+        REQUIRE(buffer.on_heap());
+        sub.rollback();
+    }
+    REQUIRE(buffer.size() == size);
+    pw.add_uint32(3, 42);
+
+    protozero::pbf_reader reader{buffer.data(), buffer.size()};
+    REQUIRE(reader.next(1));
+    REQUIRE(reader.get_uint32() == 17);
+    REQUIRE(reader.next(3));
+    REQUIRE(reader.get_uint32() == 42);
+    REQUIRE_FALSE(reader.next());
+}
+
+// Writes a message with many nested submessages of different sizes.
+template <typename TBuffer>
+static void write_nested_message(TBuffer& buffer) {
+    protozero::basic_pbf_writer<TBuffer> pw{buffer};
+    for (int i = 0; i < 20; ++i) {
+        protozero::basic_pbf_writer<TBuffer> sub{pw, 1};
+        sub.add_string(1, std::string(static_cast<std::size_t>(i * 7), 'a' + static_cast<char>(i)));
+        for (int j = 0; j < i; ++j) {
+            protozero::basic_pbf_writer<TBuffer> subsub{sub, 2};
+            subsub.add_uint64(1, static_cast<uint64_t>(j) << static_cast<unsigned>(j * 3));
+            subsub.add_fixed32(2, static_cast<uint32_t>(i));
+            if (j % 3 == 0) {
+                subsub.rollback();
+            }
+        }
+        if (i % 5 == 4) {
+            protozero::basic_pbf_writer<TBuffer> empty{sub, 3};
+        }
+    }
+}
+
+TEST_CASE("Write to segmented buffer") {
+    std::string expected;
+    write_nested_message(expected);
+
+    for (std::size_t segment_size = 16; segment_size < 100; ++segment_size) {
+        protozero::segmented_buffer buffer{segment_size};
+        REQUIRE(buffer.segment_size() == segment_size);
+        write_nested_message(buffer);
+        REQUIRE(buffer.size() == expected.size());
+        REQUIRE(buffer.num_segments() > 1);
+        REQUIRE(buffer.flatten() == expected);
+
+        std::string joined;
+        for (const auto& view : buffer.segments()) {
+            REQUIRE_FALSE(view.empty());
+            joined.append(view.data(), view.size());
+        }
+        REQUIRE(joined == expected);
+    }
+}
+
+TEST_CASE("Write test message to segmented buffer") {
+    protozero::segmented_buffer buffer{16};
+    REQUIRE(buffer.empty());
+    write_test_message(buffer);
+    REQUIRE(buffer.flatten() == expected_test_message());
+}
+
+TEST_CASE("Write large field to segmented buffer") {
+    protozero::segmented_buffer buffer{64};
+    protozero::basic_pbf_writer<protozero::segmented_buffer> pw{buffer};
+    const std::string value(1000, 'x');
+    pw.add_uint32(1, 17);
+    {
+        protozero::basic_pbf_writer<protozero::segmented_buffer> sub{pw, 2};
+        sub.add_string(1, value);
+    }
+
+    const std::string data = buffer.flatten();
+    protozero::pbf_reader reader{data};
+    REQUIRE(reader.next(1));
+    REQUIRE(reader.get_uint32() == 17);
+    REQUIRE(reader.next(2));
+    auto sub = reader.get_message();
+    REQUIRE(sub.next(1));
+    REQUIRE(sub.get_string() == value);
+    REQUIRE_FALSE(sub.next());
+    REQUIRE_FALSE(reader.next());
+}
+
+TEST_CASE("Roll back submessage spanning several segments") {
+    protozero::segmented_buffer buffer{16};
+    protozero::basic_pbf_writer<protozero::segmented_buffer> pw{buffer};
+    pw.add_uint32(1, 17);
+    const auto size = buffer.size();
+    const auto num_segments = buffer.num_segments();
+    {
+        protozero::basic_pbf_writer<protozero::segmented_buffer> sub{pw, 2};
+        sub.add_string(1, std::string(100, 'y'));
+        REQUIRE(buffer.num_segments() > num_segments);
+        sub.rollback();
+    }
+    REQUIRE(buffer.size() == size);
+    REQUIRE(buffer.num_segments() == num_segments);
+    pw.add_uint32(3, 42);
+
+    const std::string data = buffer.flatten();
+    protozero::pbf_reader reader{data};
+    REQUIRE(reader.next(1));
+    REQUIRE(reader.get_uint32() == 17);
+    REQUIRE(reader.next(3));
+    REQUIRE(reader.get_uint32() == 42);
+    REQUIRE_FALSE(reader.next());
+}
+
+TEST_CASE("Reuse segmented buffer after clear") {
+    std::string expected;
+    write_nested_message(expected);
+
+    protozero::segmented_buffer buffer{32};
+    write_nested_message(buffer);
+    buffer.clear();
+    REQUIRE(buffer.empty());
+    REQUIRE(buffer.num_segments() == 0);
+    REQUIRE(buffer.flatten().empty());
+
+    write_nested_message(buffer);
+    REQUIRE(buffer.flatten() == expected);
+}
+
+#ifndef _WIN32
+TEST_CASE("Get iovecs from segmented buffer") {
+    std::string expected;
+    write_nested_message(expected);
+
+    protozero::segmented_buffer buffer{32};
+    write_nested_message(buffer);
+
+    const auto iovecs = buffer.iovecs();
+    REQUIRE(iovecs.size() == buffer.segments().size());
+
+    std::string joined;
+    for (const auto& iov : iovecs) {
+        joined.append(static_cast<const char*>(iov.iov_base), iov.iov_len);
+    }
+    REQUIRE(joined == expected);
+}
+#endif
+
+TEST_CASE("Write large packed varint fields in chunks") {
+    // Enough values of all sizes so that the encoded data is much larger
+    // than the chunks it is written in.
+    std::vector<int64_t> values;
+    for (int64_t n = 0; n < 2000; ++n) {
+        values.push_back(n % 2 == 0 ? n * n * n * n : -n);
+    }
+
+    std::string expected_uint;
+    std::string expected_sint;
+    {
+        std::string data_uint;
+        std::string data_sint;
+        for (const auto value : values) {
+            protozero::write_varint(std::back_inserter(data_uint), static_cast<uint64_t>(value));
+            protozero::write_varint(std::back_inserter(data_sint), protozero::encode_zigzag64(value));
+        }
+        REQUIRE(data_uint.size() > 4096);
+        expected_uint = "\x0a";
+        protozero::write_varint(std::back_inserter(expected_uint), data_uint.size());
+        expected_uint += data_uint;
+        expected_sint = "\x12";
+        protozero::write_varint(std::back_inserter(expected_sint), data_sint.size());
+        expected_sint += data_sint;
+    }
+
+    SECTION("std::string") {
+        std::string buffer;
+        protozero::pbf_writer pw{buffer};
+        pw.add_packed_uint64(1, values.begin(), values.end());
+        pw.add_packed_sint64(2, values.begin(), values.end());
+        REQUIRE(buffer == expected_uint + expected_sint);
+    }
+
+    SECTION("std::vector<char>") {
+        std::vector<char> buffer;
+        protozero::basic_pbf_writer<std::vector<char>> pw{buffer};
+        pw.add_packed_uint64(1, values.begin(), values.end());
+        pw.add_packed_sint64(2, values.begin(), values.end());
+        REQUIRE(std::string(buffer.data(), buffer.size()) == expected_uint + expected_sint);
+    }
+
+    SECTION("fixed size buffer") {
+        std::vector<char> data(expected_uint.size() + expected_sint.size());
+        protozero::fixed_size_buffer_adaptor buffer{data.data(), data.size()};
+        protozero::basic_pbf_writer<protozero::fixed_size_buffer_adaptor> pw{buffer};
+        pw.add_packed_uint64(1, values.begin(), values.end());
+        pw.add_packed_sint64(2, values.begin(), values.end());
+        REQUIRE(std::string(buffer.data(), buffer.size()) == expected_uint + expected_sint);
+    }
+
+    SECTION("small buffer") {
+        protozero::small_buffer<256> buffer;
+        protozero::basic_pbf_writer<protozero::small_buffer<256>> pw{buffer};
+        pw.add_packed_uint64(1, values.begin(), values.end());
+        pw.add_packed_sint64(2, values.begin(), values.end());
+        REQUIRE(buffer.to_string() == expected_uint + expected_sint);
+    }
+
+    SECTION("segmented buffer") {
+        protozero::segmented_buffer buffer{100};
+        protozero::basic_pbf_writer<protozero::segmented_buffer> pw{buffer};
+        pw.add_packed_uint64(1, values.begin(), values.end());
+        pw.add_packed_sint64(2, values.begin(), values.end());
+        REQUIRE(buffer.flatten() == expected_uint + expected_sint);
+    }
+
+    SECTION("counting buffer") {
+        protozero::counting_buffer buffer;
+        protozero::basic_pbf_writer<protozero::counting_buffer> pw{buffer};
+        pw.add_packed_uint64(1, values.begin(), values.end());
+        pw.add_packed_sint64(2, values.begin(), values.end());
+        REQUIRE(buffer.size() == expected_uint.size() + expected_sint.size());
+    }
+}
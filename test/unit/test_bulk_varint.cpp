@@ -0,0 +1,396 @@
+
+#include <test.hpp>
+
+#include <protozero/bulk_varint.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+static std::vector<uint64_t> mixed_length_values(std::size_t count) {
+    std::vector<uint64_t> values;
+    values.reserve(count);
+
+    uint64_t state = 0x1234567887654321ULL;
+    for (std::size_t n = 0; n < count; ++n) {
+        // simple xorshift random generator
+        state ^= state << 13U;
+        state ^= state >> 7U;
+        state ^= state << 17U;
+        // get varints with all lengths from 1 to 10 bytes
+        const auto bits = static_cast<unsigned int>(state % 64) + 1;
+        values.push_back(bits == 64 ? state : (state & ((1ULL << bits) - 1)));
+    }
+
+    return values;
+}
+
+TEST_CASE("decode empty packed field") {
+    protozero::iterator_range<protozero::const_varint_iterator<uint32_t>> range{};
+    uint32_t out[1] = {17};
+    REQUIRE(protozero::decode_packed(range, out) == out);
+    REQUIRE(out[0] == 17);
+}
+
+TEST_CASE("decode packed uint64 with all varint lengths") {
+    std::string buffer;
+    protozero::pbf_writer pw{buffer};
+
+    for (std::size_t count : {1U, 15U, 16U, 17U, 40U, 1000U}) {
+        const auto values = mixed_length_values(count);
+
+        buffer.clear();
+        pw.add_packed_uint64(1, values.begin(), values.end());
+
+        protozero::pbf_reader item{buffer};
+        REQUIRE(item.next());
+        const auto range = item.get_packed_uint64();
+
+        std::vector<uint64_t> out(range.size());
+        REQUIRE(protozero::decode_packed(range, out.data()) == out.data() + out.size());
+        REQUIRE(out == values);
+    }
+}
+
+TEST_CASE("decode packed uint32 with only one-byte varints") {
+    std::vector<uint32_t> values;
+    for (uint32_t n = 0; n < 300; ++n) {
+        values.push_back(n % 128);
+    }
+
+    std::string buffer;
+    protozero::pbf_writer pw{buffer};
+    pw.add_packed_uint32(1, values.begin(), values.end());
+
+    protozero::pbf_reader item{buffer};
+    REQUIRE(item.next());
+    const auto range = item.get_packed_uint32();
+
+    std::vector<uint32_t> out(range.size());
+    protozero::decode_packed(range, out.data());
+    REQUIRE(out == values);
+}
+
+TEST_CASE("decode packed int32 with negative values") {
+    std::vector<int32_t> values;
+    for (int32_t n = -500; n < 500; n += 3) {
+        values.push_back(n * 1000);
+    }
+    values.push_back(std::numeric_limits<int32_t>::min());
+    values.push_back(std::numeric_limits<int32_t>::max());
+
+    std::string buffer;
+    protozero::pbf_writer pw{buffer};
+    pw.add_packed_int32(1, values.begin(), values.end());
+
+    protozero::pbf_reader item{buffer};
+    REQUIRE(item.next());
+    const auto range = item.get_packed_int32();
+
+    std::vector<int32_t> out(range.size());
+    protozero::decode_packed(range, out.data());
+    REQUIRE(out == values);
+}
+
+TEST_CASE("decode packed sint32 and sint64") {
+    std::vector<int64_t> values;
+    for (int64_t n = -100000; n < 100000; n += 777) {
+        values.push_back(n);
+    }
+    values.push_back(std::numeric_limits<int64_t>::min());
+    values.push_back(std::numeric_limits<int64_t>::max());
+
+    std::string buffer;
+    protozero::pbf_writer pw{buffer};
+    pw.add_packed_sint64(1, values.begin(), values.end());
+    pw.add_packed_sint32(2, values.begin(), values.end() - 2);
+
+    protozero::pbf_reader item{buffer};
+
+    REQUIRE(item.next());
+    const auto range64 = item.get_packed_sint64();
+    std::vector<int64_t> out64(range64.size());
+    protozero::decode_packed(range64, out64.data());
+    REQUIRE(out64 == values);
+
+    REQUIRE(item.next());
+    const auto range32 = item.get_packed_sint32();
+    std::vector<int32_t> out32(range32.size());
+    protozero::decode_packed(range32, out32.data());
+    REQUIRE(out32.size() == values.size() - 2);
+    REQUIRE(std::equal(out32.begin(), out32.end(), values.begin()));
+}
+
+TEST_CASE("decode_packed_varint on buffer with incomplete varint") {
+    const auto values = mixed_length_values(100);
+
+    std::string buffer;
+    for (const auto value : values) {
+        protozero::write_varint(std::back_inserter(buffer), value);
+    }
+    buffer.back() = static_cast<char>(0x80U);
+
+    std::vector<uint64_t> out(buffer.size());
+    const char* data = buffer.data();
+    REQUIRE_THROWS_AS(protozero::decode_packed_varint(&data, buffer.data() + buffer.size(), out.data()),
+                      const protozero::end_of_buffer_exception&);
+    REQUIRE(data == buffer.data());
+}
+
+TEST_CASE("decode_packed_varint on buffer with too long varint") {
+    std::string buffer(50, '\x01');
+    for (std::size_t n = 20; n < 31; ++n) {
+        buffer[n] = static_cast<char>(0xffU);
+    }
+
+    std::vector<uint64_t> out(buffer.size());
+    const char* data = buffer.data();
+    REQUIRE_THROWS_AS(protozero::decode_packed_varint(&data, buffer.data() + buffer.size(), out.data()),
+                      const protozero::varint_too_long_exception&);
+    REQUIRE(data == buffer.data());
+}
+
+TEST_CASE("decode_packed_varint on block without end of varint") {
+    std::string buffer(64, static_cast<char>(0xffU));
+
+    std::vector<uint64_t> out(buffer.size());
+    const char* data = buffer.data();
+    REQUIRE_THROWS_AS(protozero::decode_packed_varint(&data, buffer.data() + buffer.size(), out.data()),
+                      const protozero::varint_too_long_exception&);
+}
+
+TEST_CASE("decode_packed_into vector appends values of several fields") {
+    const auto values = mixed_length_values(300);
+
+    std::string buffer;
+    protozero::pbf_writer pw{buffer};
+    pw.add_packed_uint64(1, values.begin(), values.begin() + 100);
+    pw.add_packed_uint64(1, values.begin() + 100, values.end());
+
+    protozero::pbf_reader item{buffer};
+    std::vector<uint64_t> out;
+    while (item.next(1)) {
+        protozero::decode_packed_into(item.get_packed_uint64(), out);
+    }
+    REQUIRE(out == values);
+}
+
+TEST_CASE("decode_packed_into vector with many long varints") {
+    const auto values = mixed_length_values(10000);
+
+    std::string buffer;
+    protozero::pbf_writer pw{buffer};
+    pw.add_packed_uint64(1, values.begin(), values.end());
+
+    protozero::pbf_reader item{buffer};
+    REQUIRE(item.next());
+    const auto range = item.get_packed_uint64();
+    std::vector<uint64_t> out;
+    protozero::decode_packed_into(range, out);
+    REQUIRE(out == values);
+
+    // The vector doesn't grow by the number of bytes.
+    const auto bytes = static_cast<std::size_t>(range.end().data() - range.begin().data());
+    REQUIRE(out.capacity() < bytes / 2);
+}
+
+TEST_CASE("decode_packed_into vector with bools") {
+    const std::vector<bool> values{true, false, false, true, true};
+
+    std::string buffer;
+    protozero::pbf_writer pw{buffer};
+    pw.add_packed_bool(1, values.begin(), values.end());
+
+    protozero::pbf_reader item{buffer};
+    REQUIRE(item.next());
+    std::vector<bool> out{false};
+    protozero::decode_packed_into(item.get_packed_bool(), out);
+    REQUIRE(out.size() == 6);
+    REQUIRE_FALSE(out[0]);
+    REQUIRE(std::equal(values.begin(), values.end(), out.begin() + 1));
+}
+
+TEST_CASE("decode_packed_into vector with sint32") {
+    std::vector<int32_t> values;
+    for (int32_t n = -100000; n < 100000; n += 777) {
+        values.push_back(n);
+    }
+
+    std::string buffer;
+    protozero::pbf_writer pw{buffer};
+    pw.add_packed_sint32(1, values.begin(), values.end());
+
+    protozero::pbf_reader item{buffer};
+    REQUIRE(item.next());
+    std::vector<int32_t> out{1, 2};
+    protozero::decode_packed_into(item.get_packed_sint32(), out);
+    REQUIRE(out.size() == values.size() + 2);
+    REQUIRE(out[1] == 2);
+    REQUIRE(std::equal(values.begin(), values.end(), out.begin() + 2));
+}
+
+TEST_CASE("decode_packed_into vector with fixed-size values") {
+    const std::vector<double> doubles{1.5, -2.25, 0.0, 1e300};
+    const std::vector<uint32_t> fixed{0, 1, 0xffffffffU, 0x12345678U};
+
+    std::string buffer;
+    protozero::pbf_writer pw{buffer};
+    pw.add_packed_double(1, doubles.begin(), doubles.end());
+    pw.add_packed_fixed32(2, fixed.begin(), fixed.end());
+
+    protozero::pbf_reader item{buffer};
+
+    REQUIRE(item.next(1));
+    std::vector<double> out_doubles;
+    protozero::decode_packed_into(item.get_packed_double(), out_doubles);
+    REQUIRE(out_doubles == doubles);
+
+    REQUIRE(item.next(2));
+    std::vector<uint32_t> out_fixed{42};
+    protozero::decode_packed_into(item.get_packed_fixed32(), out_fixed);
+    REQUIRE(out_fixed.size() == 5);
+    REQUIRE(out_fixed[0] == 42);
+    REQUIRE(std::equal(fixed.begin(), fixed.end(), out_fixed.begin() + 1));
+}
+
+TEST_CASE("decode_packed_into vector keeps contents on error") {
+    std::string buffer;
+    for (const auto value : mixed_length_values(100)) {
+        protozero::write_varint(std::back_inserter(buffer), value);
+    }
+    buffer.back() = static_cast<char>(0x80U);
+
+    const protozero::iterator_range<protozero::const_varint_iterator<uint64_t>> range{
+        protozero::const_varint_iterator<uint64_t>{buffer.data(), buffer.data() + buffer.size()},
+        protozero::const_varint_iterator<uint64_t>{buffer.data() + buffer.size(), buffer.data() + buffer.size()}};
+
+    std::vector<uint64_t> out{7, 8, 9};
+    REQUIRE_THROWS_AS(protozero::decode_packed_into(range, out), const protozero::end_of_buffer_exception&);
+    REQUIRE(out.size() == 3);
+    REQUIRE(out[2] == 9);
+}
+
+TEST_CASE("decode_packed_into vector keeps contents on error after several chunks") {
+    std::string buffer;
+    for (const auto value : mixed_length_values(2000)) {
+        protozero::write_varint(std::back_inserter(buffer), value);
+    }
+    buffer.append(11, static_cast<char>(0x80U));
+    buffer.append(1, '\x01');
+
+    const protozero::iterator_range<protozero::const_varint_iterator<uint64_t>> range{
+        protozero::const_varint_iterator<uint64_t>{buffer.data(), buffer.data() + buffer.size()},
+        protozero::const_varint_iterator<uint64_t>{buffer.data() + buffer.size(), buffer.data() + buffer.size()}};
+
+    std::vector<uint64_t> out{7, 8, 9};
+    REQUIRE_THROWS_AS(protozero::decode_packed_into(range, out), const protozero::varint_too_long_exception&);
+    REQUIRE(out.size() == 3);
+    REQUIRE(out[2] == 9);
+}
+
+TEST_CASE("decode_packed_into array with capacity") {
+    const auto values = mixed_length_values(100);
+
+    std::string buffer;
+    protozero::pbf_writer pw{buffer};
+    pw.add_packed_uint64(1, values.begin(), values.end());
+    const std::vector<int64_t> fixed(10, -3);
+    pw.add_packed_sfixed64(2, fixed.begin(), fixed.end());
+
+    protozero::pbf_reader item{buffer};
+
+    REQUIRE(item.next(1));
+    const auto range = item.get_packed_uint64();
+    std::vector<uint64_t> out(100);
+    REQUIRE(protozero::decode_packed_into(range, out.data(), out.size()) == 100);
+    REQUIRE(out == values);
+    REQUIRE_THROWS_AS(protozero::decode_packed_into(range, out.data(), 99), const std::length_error&);
+
+    REQUIRE(item.next(2));
+    const auto frange = item.get_packed_sfixed64();
+    std::vector<int64_t> fout(10);
+    REQUIRE(protozero::decode_packed_into(frange, fout.data(), fout.size()) == 10);
+    REQUIRE(fout == fixed);
+    REQUIRE_THROWS_AS(protozero::decode_packed_into(frange, fout.data(), 9), const std::length_error&);
+}
+
+template <typename T>
+static std::vector<T> running_sums(const std::vector<T>& deltas, T base) {
+    using sum_type = typename std::make_unsigned<T>::type;
+    std::vector<T> sums;
+    auto sum = static_cast<sum_type>(base);
+    for (const auto delta : deltas) {
+        sum += static_cast<sum_type>(delta);
+        sums.push_back(static_cast<T>(sum));
+    }
+    return sums;
+}
+
+TEST_CASE("decode_packed_svarint_delta with small and large deltas") {
+    std::vector<int32_t> deltas;
+    uint32_t state = 1;
+    for (int n = 0; n < 2000; ++n) {
+        state = state * 1103515245U + 12345U;
+        // Long runs of one-byte varints (-64..63) with some larger values.
+        deltas.push_back(n % 100 < 90 ? static_cast<int32_t>((state >> 16U) % 128U) - 64 : static_cast<int32_t>(state));
+    }
+    deltas.push_back(std::numeric_limits<int32_t>::max());
+    deltas.push_back(std::numeric_limits<int32_t>::min());
+
+    std::string buffer;
+    protozero::pbf_writer pw{buffer};
+    pw.add_packed_sint32(1, deltas.begin(), deltas.end());
+    pw.add_packed_sint64(2, deltas.begin(), deltas.end());
+
+    protozero::pbf_reader item{buffer};
+
+    REQUIRE(item.next(1));
+    const auto range32 = item.get_packed_sint32();
+    std::vector<int32_t> out32(range32.size());
+    REQUIRE(protozero::decode_packed_delta(range32, out32.data(), 17) == out32.data() + out32.size());
+    REQUIRE(out32 == running_sums<int32_t>(deltas, 17));
+
+    REQUIRE(item.next(2));
+    const auto range64 = item.get_packed_sint64();
+    const std::vector<int64_t> deltas64(deltas.begin(), deltas.end());
+    std::vector<int64_t> out64(range64.size());
+    REQUIRE(protozero::decode_packed_delta(range64, out64.data(), int64_t(-5)) == out64.data() + out64.size());
+    REQUIRE(out64 == running_sums<int64_t>(deltas64, -5));
+}
+
+TEST_CASE("decode_packed_svarint_delta with all one-byte deltas") {
+    for (std::size_t count : {0U, 1U, 31U, 32U, 33U, 64U, 100U, 1000U}) {
+        std::vector<int32_t> deltas;
+        for (std::size_t n = 0; n < count; ++n) {
+            deltas.push_back(static_cast<int32_t>(n % 128) - 64);
+        }
+
+        std::string buffer;
+        for (const auto delta : deltas) {
+            protozero::write_varint(std::back_inserter(buffer), protozero::encode_zigzag32(delta));
+        }
+
+        std::vector<int32_t> out(count + 1);
+        const char* data = buffer.data();
+        const auto* last = protozero::decode_packed_svarint_delta(&data, buffer.data() + buffer.size(), out.data(), std::numeric_limits<int32_t>::max());
+        REQUIRE(last == out.data() + count);
+        REQUIRE(data == buffer.data() + buffer.size());
+        out.pop_back();
+        REQUIRE(out == running_sums<int32_t>(deltas, std::numeric_limits<int32_t>::max()));
+    }
+}
+
+TEST_CASE("decode_packed_svarint_delta on buffer with incomplete varint") {
+    std::string buffer(40, '\x02');
+    buffer.back() = static_cast<char>(0x80U);
+
+    std::vector<int64_t> out(buffer.size());
+    const char* data = buffer.data();
+    REQUIRE_THROWS_AS(protozero::decode_packed_svarint_delta(&data, buffer.data() + buffer.size(), out.data()),
+                      const protozero::end_of_buffer_exception&);
+    REQUIRE(data == buffer.data());
+}
@@ -0,0 +1,248 @@
+
+#include <test.hpp>
+
+#include <protozero/delimited_reader.hpp>
+
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifndef _WIN32
+# include <fcntl.h>
+# include <system_error>
+# include <unistd.h>
+#endif
+
+namespace {
+
+    // Create a stream of delimited messages, message n has n fields.
+    std::string create_messages(int count, std::size_t string_size = 10) {
+        std::string data;
+        for (int n = 0; n < count; ++n) {
+            std::string message;
+            protozero::pbf_writer pw{message};
+            for (int i = 0; i < n; ++i) {
+                pw.add_string(1, std::string(string_size, 'a'));
+            }
+            char length[protozero::max_varint_length];
+            data.append(length, static_cast<std::size_t>(protozero::write_varint(length, message.size())));
+            data.append(message);
+        }
+        return data;
+    }
+
+    template <typename TReader>
+    int check_messages(TReader& reader, std::size_t string_size = 10) {
+        int n = 0;
+        while (reader.next()) {
+            protozero::pbf_reader message = reader.get_message();
+            int fields = 0;
+            while (message.next(1)) {
+                REQUIRE(message.get_view().size() == string_size);
+                ++fields;
+            }
+            REQUIRE(fields == n);
+            ++n;
+        }
+        return n;
+    }
+
+    // Stream buffer without a get area, so it can't report how much data
+    // is available (showmanyc() returns 0), like the one used by std::cin.
+    class unbuffered_streambuf : public std::streambuf {
+
+        std::string m_data;
+        std::size_t m_pos = 0;
+
+    protected:
+
+        int_type underflow() override {
+            if (m_pos == m_data.size()) {
+                return traits_type::eof();
+            }
+            return traits_type::to_int_type(m_data[m_pos]);
+        }
+
+        int_type uflow() override {
+            const auto c = underflow();
+            if (c != traits_type::eof()) {
+                ++m_pos;
+            }
+            return c;
+        }
+
+    public:
+
+        explicit unbuffered_streambuf(std::string data) :
+            m_data(std::move(data)) {
+        }
+
+    }; // class unbuffered_streambuf
+
+} // anonymous namespace
+
+TEST_CASE("Read delimited messages from empty stream") {
+    std::istringstream stream{""};
+    protozero::istream_delimited_reader reader{protozero::istream_source{stream}};
+    REQUIRE_FALSE(reader.next());
+    REQUIRE_FALSE(reader.next());
+}
+
+TEST_CASE("Read delimited messages from stream") {
+    const std::string data = create_messages(50);
+
+    SECTION("default buffer size") {
+        std::istringstream stream{data};
+        protozero::istream_delimited_reader reader{protozero::istream_source{stream}};
+        REQUIRE(check_messages(reader) == 50);
+    }
+
+    SECTION("tiny buffer") {
+        std::istringstream stream{data};
+        protozero::istream_delimited_reader reader{protozero::istream_source{stream}, 3};
+        REQUIRE(check_messages(reader) == 50);
+    }
+
+    SECTION("buffer size doesn't fit messages") {
+        for (std::size_t size = 10; size < 100; size += 7) {
+            std::istringstream stream{data};
+            protozero::istream_delimited_reader reader{protozero::istream_source{stream}, size};
+            REQUIRE(check_messages(reader) == 50);
+        }
+    }
+}
+
+TEST_CASE("Read delimited messages from unbuffered stream") {
+    const std::string data = create_messages(50);
+
+    SECTION("source reads more than one byte at a time") {
+        unbuffered_streambuf buf{data};
+        std::istream stream{&buf};
+        protozero::istream_source source{stream};
+        std::vector<char> buffer(100);
+        REQUIRE(source.read(buffer.data(), buffer.size()) == buffer.size());
+    }
+
+    SECTION("source reads until the end of the stream") {
+        unbuffered_streambuf buf{"abc"};
+        std::istream stream{&buf};
+        protozero::istream_source source{stream};
+        std::vector<char> buffer(100);
+        REQUIRE(source.read(buffer.data(), buffer.size()) == 3);
+        REQUIRE(source.read(buffer.data(), buffer.size()) == 0);
+    }
+
+    SECTION("reader") {
+        unbuffered_streambuf buf{data};
+        std::istream stream{&buf};
+        protozero::istream_delimited_reader reader{protozero::istream_source{stream}, 100};
+        REQUIRE(check_messages(reader) == 50);
+    }
+}
+
+TEST_CASE("Read large delimited messages") {
+    const std::string data = create_messages(5, 100000);
+    std::istringstream stream{data};
+    protozero::istream_delimited_reader reader{protozero::istream_source{stream}, 1000};
+    REQUIRE(check_messages(reader, 100000) == 5);
+}
+
+TEST_CASE("Empty messages are returned") {
+    const std::string data(3, '\0');
+    std::istringstream stream{data};
+    protozero::istream_delimited_reader reader{protozero::istream_source{stream}};
+    for (int i = 0; i < 3; ++i) {
+        REQUIRE(reader.next());
+        REQUIRE(reader.message().size() == 0);
+        REQUIRE_FALSE(reader.get_message().next());
+    }
+    REQUIRE_FALSE(reader.next());
+}
+
+TEST_CASE("Read truncated delimited messages") {
+    std::string data = create_messages(3);
+
+    SECTION("truncated message") {
+        data.resize(data.size() - 1);
+        std::istringstream stream{data};
+        protozero::istream_delimited_reader reader{protozero::istream_source{stream}};
+        REQUIRE(reader.next());
+        REQUIRE(reader.next());
+        REQUIRE_THROWS_AS(reader.next(), const protozero::end_of_buffer_exception&);
+    }
+
+    SECTION("truncated length") {
+        data.push_back('\x80');
+        std::istringstream stream{data};
+        protozero::istream_delimited_reader reader{protozero::istream_source{stream}};
+        REQUIRE(reader.next());
+        REQUIRE(reader.next());
+        REQUIRE(reader.next());
+        REQUIRE_THROWS_AS(reader.next(), const protozero::end_of_buffer_exception&);
+    }
+}
+
+TEST_CASE("Read delimited message with invalid length") {
+    SECTION("varint too long") {
+        const std::string data(12, '\xff');
+        std::istringstream stream{data};
+        protozero::istream_delimited_reader reader{protozero::istream_source{stream}};
+        REQUIRE_THROWS_AS(reader.next(), const protozero::varint_too_long_exception&);
+    }
+
+    SECTION("message too large") {
+        const std::string data = create_messages(3, 1000);
+        std::istringstream stream{data};
+        protozero::istream_delimited_reader reader{protozero::istream_source{stream}, 100, 1500};
+        REQUIRE(reader.next());
+        REQUIRE(reader.next());
+        REQUIRE_THROWS_AS(reader.next(), const protozero::invalid_length_exception&);
+    }
+}
+
+#ifndef _WIN32
+TEST_CASE("Read delimited messages from pipe") {
+    // Small enough to fit into the pipe buffer.
+    const std::string data = create_messages(25);
+    REQUIRE(data.size() < 4096);
+
+    int fds[2];
+    REQUIRE(::pipe(fds) == 0);
+    REQUIRE(::write(fds[1], data.data(), data.size()) == static_cast<ssize_t>(data.size()));
+    ::close(fds[1]);
+
+    protozero::fd_delimited_reader reader{protozero::fd_source{fds[0]}, 64};
+    REQUIRE(check_messages(reader) == 25);
+    ::close(fds[0]);
+}
+
+TEST_CASE("Read short delimited messages from pipe still open for writing") {
+    int fds[2];
+    REQUIRE(::pipe(fds) == 0);
+    // Reading more than is in the pipe fails instead of blocking the test.
+    REQUIRE(::fcntl(fds[0], F_SETFL, O_NONBLOCK) == 0);
+
+    protozero::fd_delimited_reader reader{protozero::fd_source{fds[0]}};
+
+    const std::string message{"\x03\x08\x96\x01", 4};
+    for (int n = 0; n < 3; ++n) {
+        REQUIRE(::write(fds[1], message.data(), message.size()) == static_cast<ssize_t>(message.size()));
+        REQUIRE(reader.next());
+        REQUIRE(reader.message().size() == 3);
+        protozero::pbf_reader item = reader.get_message();
+        REQUIRE(item.next(1));
+        REQUIRE(item.get_uint32() == 150);
+    }
+
+    ::close(fds[1]);
+    REQUIRE_FALSE(reader.next());
+    ::close(fds[0]);
+}
+
+TEST_CASE("Read delimited messages from invalid file descriptor") {
+    protozero::fd_delimited_reader reader{protozero::fd_source{-1}};
+    REQUIRE_THROWS_AS(reader.next(), const std::system_error&);
+}
+#endif
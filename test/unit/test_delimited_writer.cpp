@@ -0,0 +1,274 @@
+
+#include <test.hpp>
+
+#include <protozero/delimited_reader.hpp>
+#include <protozero/delimited_writer.hpp>
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+# include <sys/uio.h>
+# include <system_error>
+# include <unistd.h>
+#endif
+
+namespace {
+
+    // Sink remembering the size of all writes.
+    class recording_sink {
+
+        std::string* m_data;
+        std::vector<std::size_t>* m_writes;
+
+    public:
+
+        recording_sink(std::string& data, std::vector<std::size_t>& writes) :
+            m_data(&data),
+            m_writes(&writes) {
+        }
+
+        void write(const char* data, std::size_t size) {
+            m_data->append(data, size);
+            m_writes->push_back(size);
+        }
+
+    }; // class recording_sink
+
+    // Sink appending to a string or throwing if told to.
+    class failing_sink {
+
+        std::string* m_data;
+        const bool* m_fail;
+
+    public:
+
+        failing_sink(std::string& data, const bool& fail) :
+            m_data(&data),
+            m_fail(&fail) {
+        }
+
+        void write(const char* data, std::size_t size) {
+            if (*m_fail) {
+                throw std::runtime_error{"write failed"};
+            }
+            m_data->append(data, size);
+        }
+
+    }; // class failing_sink
+
+#ifndef _WIN32
+    // Sink with gathered writes remembering the size of all writes.
+    class gathering_sink : public recording_sink {
+
+    public:
+
+        using recording_sink::recording_sink;
+        using recording_sink::write;
+
+        void write(const iovec* iov, int count) {
+            std::string data;
+            for (int n = 0; n < count; ++n) {
+                data.append(static_cast<const char*>(iov[n].iov_base), iov[n].iov_len);
+            }
+            write(data.data(), data.size());
+        }
+
+    }; // class gathering_sink
+#endif
+
+    template <typename TWriter>
+    void add_messages(TWriter& writer, int count, std::size_t string_size = 10) {
+        for (int n = 0; n < count; ++n) {
+            writer.add_message([&](protozero::pbf_writer& pw) {
+                for (int i = 0; i < n; ++i) {
+                    pw.add_string(1, std::string(string_size, 'a'));
+                }
+            });
+        }
+    }
+
+    int check_messages(const std::string& data, std::size_t string_size = 10) {
+        std::istringstream stream{data};
+        protozero::istream_delimited_reader reader{protozero::istream_source{stream}};
+        int n = 0;
+        while (reader.next()) {
+            protozero::pbf_reader message = reader.get_message();
+            int fields = 0;
+            while (message.next(1)) {
+                REQUIRE(message.get_view().size() == string_size);
+                ++fields;
+            }
+            REQUIRE(fields == n);
+            ++n;
+        }
+        return n;
+    }
+
+} // anonymous namespace
+
+TEST_CASE("Write delimited messages to stream") {
+    std::ostringstream stream;
+    {
+        protozero::ostream_delimited_writer writer{protozero::ostream_sink{stream}};
+        REQUIRE(writer.flush_threshold() == protozero::ostream_delimited_writer::default_flush_threshold);
+        add_messages(writer, 50);
+        REQUIRE(writer.buffered() > 0);
+        REQUIRE(stream.str().empty());
+        writer.flush();
+        REQUIRE(writer.buffered() == 0);
+    }
+    REQUIRE(check_messages(stream.str()) == 50);
+}
+
+TEST_CASE("Destructor of delimited writer flushes") {
+    std::ostringstream stream;
+    {
+        protozero::ostream_delimited_writer writer{protozero::ostream_sink{stream}};
+        add_messages(writer, 10);
+    }
+    REQUIRE(check_messages(stream.str()) == 10);
+}
+
+TEST_CASE("Write encoded delimited messages") {
+    std::string message;
+    protozero::pbf_writer pw{message};
+    pw.add_string(1, "aaaaaaaaaa");
+
+    std::ostringstream stream;
+    {
+        protozero::ostream_delimited_writer writer{protozero::ostream_sink{stream}};
+        writer.add_message(std::string{});
+        writer.add_message(message);
+        writer.add_message(protozero::data_view{message.data(), message.size()});
+    }
+
+    const std::string expected = std::string{"\x00\x0c", 2} + message + "\x0c" + message;
+    REQUIRE(stream.str() == expected);
+}
+
+TEST_CASE("Delimited writer batches writes") {
+    std::string data;
+    std::vector<std::size_t> writes;
+
+    SECTION("writes when threshold is reached") {
+        protozero::basic_delimited_writer<recording_sink> writer{recording_sink{data, writes}, 1000};
+        add_messages(writer, 20);
+        for (const auto size : writes) {
+            REQUIRE(size >= 1000);
+        }
+        REQUIRE_FALSE(writes.empty());
+        REQUIRE(writer.buffered() < 1000);
+        writer.flush();
+        REQUIRE(check_messages(data) == 20);
+    }
+
+    SECTION("threshold 0 writes every message") {
+        protozero::basic_delimited_writer<recording_sink> writer{recording_sink{data, writes}, 0};
+        add_messages(writer, 20);
+        REQUIRE(writer.buffered() == 0);
+        REQUIRE(writes.size() == 2 * 20);
+        REQUIRE(check_messages(data) == 20);
+    }
+
+    SECTION("large messages are written directly") {
+        protozero::basic_delimited_writer<recording_sink> writer{recording_sink{data, writes}, 1000};
+        add_messages(writer, 5, 100000);
+        writer.flush();
+        REQUIRE(check_messages(data, 100000) == 5);
+    }
+
+    SECTION("nothing to flush") {
+        protozero::basic_delimited_writer<recording_sink> writer{recording_sink{data, writes}};
+        writer.flush();
+        REQUIRE(writes.empty());
+    }
+}
+
+#ifndef _WIN32
+TEST_CASE("Delimited writer writes large messages with one gathered write") {
+    std::string data;
+    std::vector<std::size_t> writes;
+    {
+        protozero::basic_delimited_writer<gathering_sink> writer{gathering_sink{data, writes}, 1000};
+        add_messages(writer, 5, 100000);
+    }
+    // The first (empty) message is flushed before the second one, the other
+    // four messages are written with one call each.
+    REQUIRE(writes.size() == 5);
+    REQUIRE(check_messages(data, 100000) == 5);
+}
+#endif
+
+TEST_CASE("Delimited writer can be moved") {
+    std::string data;
+    std::vector<std::size_t> writes;
+    {
+        protozero::basic_delimited_writer<recording_sink> writer{recording_sink{data, writes}};
+        add_messages(writer, 5);
+        protozero::basic_delimited_writer<recording_sink> writer2{std::move(writer)};
+        add_messages(writer2, 5);
+    }
+    REQUIRE(writes.size() == 1);
+}
+
+TEST_CASE("Delimited writer only keeps complete messages if the sink throws") {
+    std::string data;
+    bool fail = false;
+    protozero::basic_delimited_writer<failing_sink> writer{failing_sink{data, fail}, 1000};
+    add_messages(writer, 5);
+    const auto buffered = writer.buffered();
+    REQUIRE(buffered > 0);
+
+    fail = true;
+
+    SECTION("large message") {
+        REQUIRE_THROWS_AS(writer.add_message(std::string(2000, 'a')), const std::runtime_error&);
+    }
+
+    SECTION("message filling the batch") {
+        REQUIRE_THROWS_AS(writer.add_message([](protozero::pbf_writer& pw) {
+            for (int i = 0; i < 80; ++i) {
+                pw.add_string(1, std::string(10, 'a'));
+            }
+        }), const std::runtime_error&);
+    }
+
+    REQUIRE(writer.buffered() == buffered);
+    REQUIRE(data.empty());
+
+    fail = false;
+    writer.flush();
+    REQUIRE(check_messages(data) == 5);
+}
+
+#ifndef _WIN32
+TEST_CASE("Write delimited messages to pipe") {
+    int fds[2];
+    REQUIRE(::pipe(fds) == 0);
+    {
+        protozero::fd_delimited_writer writer{protozero::fd_sink{fds[1]}, 64};
+        // Small enough to fit into the pipe buffer.
+        add_messages(writer, 25);
+    }
+    ::close(fds[1]);
+
+    std::string data;
+    char buffer[256];
+    ssize_t count = 0;
+    while ((count = ::read(fds[0], buffer, sizeof(buffer))) > 0) {
+        data.append(buffer, static_cast<std::size_t>(count));
+    }
+    ::close(fds[0]);
+
+    REQUIRE(check_messages(data) == 25);
+}
+
+TEST_CASE("Write delimited messages to invalid file descriptor") {
+    protozero::fd_delimited_writer writer{protozero::fd_sink{-1}};
+    add_messages(writer, 3);
+    REQUIRE_THROWS_AS(writer.flush(), const std::system_error&);
+}
+#endif
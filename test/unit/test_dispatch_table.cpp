@@ -0,0 +1,128 @@
+
+#include <test.hpp>
+
+#include <protozero/dispatch_table.hpp>
+
+#include <string>
+#include <vector>
+
+namespace {
+
+    enum class Feature : protozero::pbf_tag_type {
+        id       = 1,
+        tags     = 2,
+        type     = 3,
+        geometry = 4,
+        name     = 5,
+        big      = 100000
+    };
+
+    struct feature {
+        uint64_t id = 0;
+        std::vector<uint32_t> tags;
+        int32_t type = 0;
+        std::string name;
+        uint32_t big = 0;
+        int unknown = 0;
+    };
+
+    using feature_table = protozero::dispatch_table<Feature, feature>;
+
+    feature_table create_table() {
+        return feature_table{}
+            .on(Feature::id, protozero::pbf_wire_type::varint,
+                [](protozero::pbf_message<Feature>& m, feature& f) { f.id = m.get_uint64(); })
+            .on(Feature::tags, protozero::pbf_wire_type::length_delimited,
+                [](protozero::pbf_message<Feature>& m, feature& f) {
+                    const auto range = m.get_packed_uint32();
+                    f.tags.assign(range.begin(), range.end());
+                })
+            .on(Feature::type, protozero::pbf_wire_type::varint,
+                [](protozero::pbf_message<Feature>& m, feature& f) { f.type = m.get_enum(); })
+            .on(Feature::name, protozero::pbf_wire_type::length_delimited,
+                [](protozero::pbf_message<Feature>& m, feature& f) { f.name = m.get_string(); })
+            .on(Feature::big, protozero::pbf_wire_type::fixed32,
+                [](protozero::pbf_message<Feature>& m, feature& f) { f.big = m.get_fixed32(); });
+    }
+
+    std::string create_message() {
+        std::string buffer;
+        protozero::pbf_builder<Feature> pb{buffer};
+        pb.add_uint64(Feature::id, 17);
+        const std::vector<uint32_t> tags = {1, 2, 3, 300};
+        pb.add_packed_uint32(Feature::tags, tags.begin(), tags.end());
+        pb.add_enum(Feature::type, 3);
+        pb.add_string(Feature::geometry, "not handled");
+        pb.add_fixed32(Feature::big, 42);
+        pb.add_string(Feature::name, "foo");
+        pb.add_fixed64(Feature::type, 99); // wrong wire type
+        return buffer;
+    }
+
+} // anonymous namespace
+
+TEST_CASE("Empty dispatch table skips all fields") {
+    const std::string buffer = create_message();
+    const feature_table table;
+    feature f;
+    table.decode(protozero::pbf_message<Feature>{buffer}, f);
+    REQUIRE(f.id == 0);
+    REQUIRE(f.name.empty());
+}
+
+TEST_CASE("Dispatch table calls handlers") {
+    const std::string buffer = create_message();
+    const feature_table table = create_table();
+
+    feature f;
+    table.decode(protozero::pbf_message<Feature>{buffer}, f);
+
+    REQUIRE(f.id == 17);
+    REQUIRE(f.tags == std::vector<uint32_t>({1, 2, 3, 300}));
+    REQUIRE(f.type == 3);
+    REQUIRE(f.name == "foo");
+    REQUIRE(f.big == 42);
+}
+
+TEST_CASE("Dispatch table with handler for unknown fields") {
+    const std::string buffer = create_message();
+    feature_table table = create_table();
+    table.on_unknown([](protozero::pbf_message<Feature>& m, feature& f) {
+        ++f.unknown;
+        m.skip();
+    });
+
+    feature f;
+    table.decode(protozero::pbf_message<Feature>{buffer}, f);
+
+    REQUIRE(f.id == 17);
+    REQUIRE(f.unknown == 2);
+}
+
+TEST_CASE("Dispatch table handler lookup") {
+    feature_table table = create_table();
+
+    REQUIRE(table.handler(1, protozero::pbf_wire_type::varint) != nullptr);
+    REQUIRE(table.handler(1, protozero::pbf_wire_type::fixed32) == nullptr);
+    REQUIRE(table.handler(4, protozero::pbf_wire_type::length_delimited) == nullptr);
+    REQUIRE(table.handler(100000, protozero::pbf_wire_type::fixed32) != nullptr);
+    REQUIRE(table.handler(100001, protozero::pbf_wire_type::fixed32) == nullptr);
+    REQUIRE(table.handler(99999, protozero::pbf_wire_type::fixed32) == nullptr);
+
+    // replace handler
+    table.on(Feature::big, protozero::pbf_wire_type::fixed32,
+             [](protozero::pbf_message<Feature>& m, feature& f) { f.big = m.get_fixed32() + 1; });
+    const std::string buffer = create_message();
+    feature f;
+    table.decode(protozero::pbf_message<Feature>{buffer}, f);
+    REQUIRE(f.big == 43);
+}
+
+TEST_CASE("Dispatch table throws on invalid message") {
+    std::string buffer = create_message();
+    buffer.resize(buffer.size() - 1);
+
+    const feature_table table = create_table();
+    feature f;
+    REQUIRE_THROWS_AS(table.decode(protozero::pbf_message<Feature>{buffer}, f), const protozero::end_of_buffer_exception&);
+}
@@ -31,3 +31,7 @@ TEST_CASE("exceptions messages for invalid length") {
     REQUIRE(std::string{e.what()} == std::string{"invalid length exception"});
 }
 
+TEST_CASE("exceptions messages for invalid geometry") {
+    protozero::invalid_geometry_exception e;
+    REQUIRE(std::string{e.what()} == std::string{"invalid geometry exception"});
+}
@@ -0,0 +1,159 @@
+
+#include <test.hpp>
+
+#include <protozero/field_index.hpp>
+
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace {
+
+    std::string create_message() {
+        std::string buffer;
+        protozero::pbf_writer pw{buffer};
+        pw.add_uint32(7, 700);
+        pw.add_string(2, "foo");
+        pw.add_fixed64(5, 123456789);
+        pw.add_uint32(7, 701);
+        pw.add_fixed32(3, 33);
+        pw.add_string(2, "bar");
+        pw.add_string(9, "");
+        {
+            protozero::pbf_writer sub{pw, 4};
+            sub.add_int32(1, -1);
+        }
+        pw.add_uint32(7, 702);
+        return buffer;
+    }
+
+} // anonymous namespace
+
+TEST_CASE("Default constructed field index is empty") {
+    const protozero::field_index index;
+    REQUIRE(index.empty());
+    REQUIRE(index.size() == 0);
+    REQUIRE(index.begin() == index.end());
+    REQUIRE_FALSE(index.find(1));
+}
+
+TEST_CASE("Field index of empty message") {
+    const std::string buffer;
+    const protozero::field_index index{protozero::pbf_reader{buffer}};
+    REQUIRE(index.empty());
+    REQUIRE_FALSE(index.contains(1));
+}
+
+TEST_CASE("Field index lookups") {
+    const std::string buffer = create_message();
+    const protozero::field_index index{protozero::pbf_reader{buffer}};
+
+    REQUIRE(index.size() == 9);
+
+    // entries are sorted by tag
+    std::vector<protozero::pbf_tag_type> tags;
+    for (const auto& e : index) {
+        tags.push_back(e.tag);
+    }
+    REQUIRE(tags == std::vector<protozero::pbf_tag_type>({2, 2, 3, 4, 5, 7, 7, 7, 9}));
+
+    SECTION("missing tags") {
+        REQUIRE_FALSE(index.contains(1));
+        REQUIRE_FALSE(index.contains(6));
+        REQUIRE_FALSE(index.contains(100));
+        REQUIRE(index.count(6) == 0);
+        REQUIRE_FALSE(index.find(6));
+        REQUIRE(index.find_all(6).empty());
+    }
+
+    SECTION("scalar fields") {
+        auto f3 = index.find(3);
+        REQUIRE(f3);
+        REQUIRE(f3.tag() == 3);
+        REQUIRE(f3.wire_type() == protozero::pbf_wire_type::fixed32);
+        REQUIRE(f3.get_fixed32() == 33);
+        REQUIRE_FALSE(f3.next());
+
+        auto f5 = index.find(5, protozero::pbf_wire_type::fixed64);
+        REQUIRE(f5);
+        REQUIRE(f5.get_fixed64() == 123456789);
+
+        REQUIRE_FALSE(index.find(5, protozero::pbf_wire_type::varint));
+    }
+
+    SECTION("repeated fields keep their order") {
+        REQUIRE(index.count(7) == 3);
+        REQUIRE(index.find(7).get_uint32() == 700);
+
+        std::vector<uint32_t> values;
+        for (const auto& e : index.find_all(7)) {
+            REQUIRE(e.wire_type == protozero::pbf_wire_type::varint);
+            values.push_back(index.get(e).get_uint32());
+        }
+        REQUIRE(values == std::vector<uint32_t>({700, 701, 702}));
+
+        std::vector<std::string> strings;
+        for (const auto& e : index.find_all(2)) {
+            strings.push_back(index.get(e).get_string());
+        }
+        REQUIRE(strings == std::vector<std::string>({"foo", "bar"}));
+    }
+
+    SECTION("empty string") {
+        auto f9 = index.find(9);
+        REQUIRE(f9);
+        REQUIRE(f9.get_string().empty());
+    }
+
+    SECTION("submessage") {
+        auto f4 = index.find(4);
+        REQUIRE(f4);
+        auto sub = f4.get_message();
+        REQUIRE(sub.next(1));
+        REQUIRE(sub.get_int32() == -1);
+    }
+
+    SECTION("offsets and lengths") {
+        const auto range = index.find_all(7);
+        const auto& first = *range.begin();
+        REQUIRE(first.offset == 0);
+        REQUIRE(first.length == 3);
+        REQUIRE(index.begin()->offset == 3);
+        REQUIRE(index.begin()->length == 5);
+    }
+}
+
+TEST_CASE("Field index view of field") {
+    const std::string buffer = create_message();
+    const protozero::field_index index{protozero::pbf_reader{buffer}};
+
+    const auto range = index.find_all(2);
+    const auto view = index.view(*std::next(range.begin()));
+    REQUIRE(view.size() == 5);
+    REQUIRE(std::string(view.data(), view.size()) == std::string("\x12\x03" "bar"));
+    REQUIRE(view.data() == buffer.data() + std::next(range.begin())->offset);
+}
+
+TEST_CASE("Field index of partially read message") {
+    const std::string buffer = create_message();
+    protozero::pbf_reader message{buffer};
+    REQUIRE(message.next());
+    message.skip();
+
+    const protozero::field_index index{message};
+    REQUIRE(index.size() == 8);
+    REQUIRE(index.count(7) == 2);
+    REQUIRE(index.find(7).get_uint32() == 701);
+
+    // original reader is not changed
+    REQUIRE(message.next(2));
+    REQUIRE(message.get_string() == "foo");
+}
+
+TEST_CASE("Field index of invalid message throws") {
+    std::string buffer = create_message();
+    buffer.resize(buffer.size() - 1);
+
+    const protozero::data_view view{buffer.data(), buffer.size()};
+    REQUIRE_THROWS_AS(protozero::field_index{view}, const protozero::end_of_buffer_exception&);
+}
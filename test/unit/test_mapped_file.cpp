@@ -0,0 +1,113 @@
+
+#include <test.hpp>
+
+#include <protozero/mapped_file.hpp>
+
+#ifndef _WIN32
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#include <unistd.h>
+
+namespace {
+
+    // Temporary file with the specified content, removed in destructor.
+    class temp_file {
+
+        std::string m_name{"protozero-test-XXXXXX"};
+
+    public:
+
+        explicit temp_file(const std::string& content) {
+            const int fd = ::mkstemp(&m_name[0]);
+            REQUIRE(fd >= 0);
+            REQUIRE(::write(fd, content.data(), content.size()) == static_cast<ssize_t>(content.size()));
+            ::close(fd);
+        }
+
+        temp_file(const temp_file&) = delete;
+        temp_file& operator=(const temp_file&) = delete;
+
+        ~temp_file() {
+            std::remove(m_name.c_str());
+        }
+
+        const std::string& name() const noexcept {
+            return m_name;
+        }
+
+    }; // class temp_file
+
+} // anonymous namespace
+
+TEST_CASE("Default constructed mapped file is empty") {
+    const protozero::mapped_file file;
+    REQUIRE(file.empty());
+    REQUIRE(file.size() == 0);
+    REQUIRE(file.data() == nullptr);
+    REQUIRE(file.view().empty());
+}
+
+TEST_CASE("Map file with message") {
+    std::string data;
+    protozero::pbf_writer pw{data};
+    pw.add_string(1, "foo");
+    pw.add_uint32(2, 17);
+    const temp_file tmp{data};
+
+    SECTION("default access") {
+        const protozero::mapped_file file{tmp.name()};
+        REQUIRE(file.size() == data.size());
+        REQUIRE(std::string(file.data(), file.size()) == data);
+
+        protozero::pbf_reader reader{file.view()};
+        REQUIRE(reader.next(1));
+        REQUIRE(reader.get_string() == "foo");
+        REQUIRE(reader.next(2));
+        REQUIRE(reader.get_uint32() == 17);
+        REQUIRE_FALSE(reader.next());
+    }
+
+    SECTION("random access") {
+        const protozero::mapped_file file{tmp.name().c_str(), protozero::mapped_file_access::random};
+        REQUIRE(std::string(file.data(), file.size()) == data);
+        file.advise(2, 3, protozero::mapped_file_access::will_need);
+        file.advise(0, file.size(), protozero::mapped_file_access::normal);
+        file.advise(file.size(), 0, protozero::mapped_file_access::normal);
+        REQUIRE_THROWS_AS(file.advise(1, file.size(), protozero::mapped_file_access::normal), const assert_error&);
+    }
+}
+
+TEST_CASE("Map empty file") {
+    const temp_file tmp{""};
+    const protozero::mapped_file file{tmp.name()};
+    REQUIRE(file.empty());
+    REQUIRE_FALSE(protozero::pbf_reader{file.view()}.next());
+}
+
+TEST_CASE("Move mapped file") {
+    const temp_file tmp{"abc"};
+    protozero::mapped_file file{tmp.name()};
+
+    protozero::mapped_file file2{std::move(file)};
+    REQUIRE(file.empty()); // NOLINT(bugprone-use-after-move)
+    REQUIRE(file2.size() == 3);
+
+    file = std::move(file2);
+    REQUIRE(file2.empty()); // NOLINT(bugprone-use-after-move)
+    REQUIRE(std::string(file.data(), file.size()) == "abc");
+}
+
+TEST_CASE("Map file that doesn't exist") {
+    REQUIRE_THROWS_AS(protozero::mapped_file{"protozero-test-does-not-exist"}, const std::system_error&);
+}
+
+TEST_CASE("Map something that isn't a regular file") {
+    REQUIRE_THROWS_AS(protozero::mapped_file{"."}, const std::system_error&);
+}
+
+#endif
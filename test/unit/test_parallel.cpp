@@ -0,0 +1,250 @@
+
+#include <test.hpp>
+
+#include <protozero/parallel.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+    // Message with count submessages (tag 1), each containing its index
+    // (tag 1) and the numbers from 0 to index (tag 2). There is a string
+    // field (tag 2) between the submessages.
+    std::string create_message(uint32_t count) {
+        std::string buffer;
+        protozero::pbf_writer pw{buffer};
+        for (uint32_t n = 0; n < count; ++n) {
+            protozero::pbf_writer sub{pw, 1};
+            sub.add_uint32(1, n);
+            for (uint32_t i = 0; i <= n; ++i) {
+                sub.add_uint32(2, i);
+            }
+            sub.commit();
+            pw.add_string(2, "foo");
+        }
+        return buffer;
+    }
+
+    uint64_t sum_of_submessage(const protozero::data_view& view) {
+        protozero::pbf_reader reader{view};
+        uint64_t sum = 0;
+        while (reader.next(2)) {
+            sum += reader.get_uint32();
+        }
+        return sum;
+    }
+
+} // anonymous namespace
+
+TEST_CASE("thread pool size") {
+    protozero::thread_pool pool1{1};
+    REQUIRE(pool1.size() == 1);
+
+    protozero::thread_pool pool4{4};
+    REQUIRE(pool4.size() == 4);
+
+    protozero::thread_pool pool_default;
+    REQUIRE(pool_default.size() >= 1);
+}
+
+TEST_CASE("thread pool calls function for each index exactly once") {
+    protozero::thread_pool pool{4};
+
+    for (std::size_t count : {0U, 1U, 2U, 3U, 100U, 10000U}) {
+        std::vector<std::atomic<int>> calls(count);
+        for (auto& c : calls) {
+            c = 0;
+        }
+        std::atomic<bool> thread_ok{true};
+
+        pool.for_each_index(count, [&](std::size_t index, std::size_t thread) {
+            ++calls[index];
+            if (thread >= pool.size()) {
+                thread_ok = false;
+            }
+        });
+
+        for (const auto& c : calls) {
+            REQUIRE(c == 1);
+        }
+        REQUIRE(thread_ok);
+    }
+}
+
+TEST_CASE("thread pool propagates exception") {
+    protozero::thread_pool pool{3};
+
+    REQUIRE_THROWS_AS(pool.for_each_index(1000, [](std::size_t index, std::size_t /*thread*/) {
+        if (index == 17) {
+            throw std::runtime_error{"error"};
+        }
+    }), const std::runtime_error&);
+
+    // pool can still be used
+    std::atomic<std::size_t> count{0};
+    pool.for_each_index(50, [&](std::size_t /*index*/, std::size_t /*thread*/) {
+        ++count;
+    });
+    REQUIRE(count == 50);
+}
+
+TEST_CASE("collect submessages") {
+    const auto buffer = create_message(5);
+    const auto views = protozero::collect_submessages(protozero::data_view{buffer.data(), buffer.size()}, 1);
+    REQUIRE(views.size() == 5);
+
+    protozero::pbf_reader reader{views[3]};
+    REQUIRE(reader.next(1));
+    REQUIRE(reader.get_uint32() == 3);
+
+    REQUIRE(protozero::collect_submessages(protozero::data_view{buffer.data(), buffer.size()}, 3).empty());
+}
+
+TEST_CASE("parallel_map returns results in input order") {
+    const auto buffer = create_message(300);
+    const protozero::data_view message{buffer.data(), buffer.size()};
+
+    for (std::size_t threads : {1U, 2U, 5U}) {
+        protozero::thread_pool pool{threads};
+        const auto results = protozero::parallel_decode_submessages(pool, message, 1, sum_of_submessage);
+        REQUIRE(results.size() == 300);
+        for (uint64_t n = 0; n < results.size(); ++n) {
+            REQUIRE(results[n] == n * (n + 1) / 2);
+        }
+    }
+}
+
+TEST_CASE("parallel_map with lambda returning strings") {
+    const auto buffer = create_message(20);
+    const auto views = protozero::collect_submessages(protozero::data_view{buffer.data(), buffer.size()}, 1);
+
+    protozero::thread_pool pool{3};
+    const auto results = protozero::parallel_map(pool, views, [](const protozero::data_view& view) {
+        protozero::pbf_reader reader{view};
+        reader.next(1);
+        return std::to_string(reader.get_uint32());
+    });
+
+    REQUIRE(results.size() == 20);
+    REQUIRE(results[0] == "0");
+    REQUIRE(results[19] == "19");
+}
+
+TEST_CASE("parallel_map on invalid data") {
+    const std::string buffer{"\x0a\x02\x08"}; // submessage is cut off
+    protozero::thread_pool pool{2};
+    REQUIRE_THROWS_AS(protozero::parallel_decode_submessages(pool, protozero::data_view{buffer.data(), buffer.size()}, 1, sum_of_submessage),
+                      const protozero::end_of_buffer_exception&);
+}
+
+TEST_CASE("split message into slices") {
+    const auto buffer = create_message(100);
+    const protozero::data_view message{buffer.data(), buffer.size()};
+
+    for (std::size_t num_slices : {0U, 1U, 2U, 7U, 64U, 1000U}) {
+        const auto slices = protozero::split_message(message, num_slices);
+        REQUIRE_FALSE(slices.empty());
+        REQUIRE(slices.size() <= std::max(num_slices, std::size_t{1}));
+        REQUIRE(slices.size() <= 200); // number of fields
+
+        // slices are consecutive and cover the whole message
+        const char* p = buffer.data();
+        uint32_t count = 0;
+        for (const auto& slice : slices) {
+            REQUIRE(slice.data() == p);
+            REQUIRE(slice.size() > 0);
+            p += slice.size();
+            protozero::pbf_reader reader{slice};
+            while (reader.next(1)) {
+                protozero::pbf_reader sub{reader.get_message()};
+                REQUIRE(sub.next(1));
+                REQUIRE(sub.get_uint32() == count);
+                ++count;
+            }
+        }
+        REQUIRE(p == buffer.data() + buffer.size());
+        REQUIRE(count == 100);
+    }
+}
+
+TEST_CASE("split empty message") {
+    REQUIRE(protozero::split_message(protozero::data_view{}, 4).empty());
+}
+
+TEST_CASE("split message using field index") {
+    const auto buffer = create_message(100);
+    const protozero::field_index index{protozero::data_view{buffer.data(), buffer.size()}};
+
+    const auto slices = protozero::split_message(index, 1, 8);
+    REQUIRE(slices.size() <= 8);
+    REQUIRE(slices.front().data() == buffer.data());
+
+    uint32_t count = 0;
+    for (const auto& slice : slices) {
+        protozero::pbf_reader reader{slice};
+        while (reader.next(1)) {
+            protozero::pbf_reader sub{reader.get_message()};
+            REQUIRE(sub.next(1));
+            REQUIRE(sub.get_uint32() == count);
+            ++count;
+        }
+    }
+    REQUIRE(count == 100);
+
+    REQUIRE(protozero::split_message(index, 5, 8).empty());
+}
+
+TEST_CASE("parallel reduce with per-thread state") {
+    const auto buffer = create_message(200);
+    const protozero::data_view message{buffer.data(), buffer.size()};
+
+    uint64_t expected = 0;
+    for (uint64_t n = 0; n < 200; ++n) {
+        expected += n * (n + 1) / 2;
+    }
+
+    for (std::size_t threads : {1U, 3U}) {
+        protozero::thread_pool pool{threads};
+        const auto sums = protozero::parallel_scan(pool, message, uint64_t{0}, [](protozero::pbf_reader& reader, uint64_t& sum) {
+            while (reader.next(1)) {
+                sum += sum_of_submessage(reader.get_view());
+            }
+        });
+        REQUIRE(sums.size() == threads);
+
+        uint64_t total = 0;
+        for (const auto sum : sums) {
+            total += sum;
+        }
+        REQUIRE(total == expected);
+    }
+}
+
+TEST_CASE("parallel reduce with vector state") {
+    const auto buffer = create_message(50);
+    protozero::thread_pool pool{2};
+    const auto slices = protozero::split_message(protozero::data_view{buffer.data(), buffer.size()}, 10);
+
+    const auto states = protozero::parallel_reduce(pool, slices, std::vector<uint32_t>{}, [](protozero::pbf_reader& reader, std::vector<uint32_t>& ids) {
+        while (reader.next(1)) {
+            protozero::pbf_reader sub{reader.get_message()};
+            sub.next(1);
+            ids.push_back(sub.get_uint32());
+        }
+    });
+
+    std::vector<uint32_t> all;
+    for (const auto& ids : states) {
+        all.insert(all.end(), ids.begin(), ids.end());
+    }
+    std::sort(all.begin(), all.end());
+    REQUIRE(all.size() == 50);
+    REQUIRE(all.front() == 0);
+    REQUIRE(all.back() == 49);
+}
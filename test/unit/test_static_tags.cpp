@@ -0,0 +1,141 @@
+#include <test.hpp>
+
+#include <protozero/buffer_vector.hpp>
+
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace {
+
+    enum class Test : protozero::pbf_tag_type {
+        small  = 1,
+        medium = 2000,
+        large  = 300000000
+    };
+
+    // Write all kinds of fields with tags given at runtime.
+    template <typename TBuffer>
+    void write_dynamic(TBuffer& buffer, protozero::pbf_tag_type tag) {
+        protozero::basic_pbf_writer<TBuffer> pw{buffer};
+        pw.add_bool(tag, true);
+        pw.add_enum(tag, -3);
+        pw.add_int32(tag, -17);
+        pw.add_sint32(tag, -17);
+        pw.add_uint32(tag, 300);
+        pw.add_int64(tag, std::numeric_limits<int64_t>::min());
+        pw.add_sint64(tag, std::numeric_limits<int64_t>::min());
+        pw.add_uint64(tag, std::numeric_limits<uint64_t>::max());
+        pw.add_fixed32(tag, 12345678);
+        pw.add_sfixed32(tag, -12345678);
+        pw.add_fixed64(tag, 1234567890123ULL);
+        pw.add_sfixed64(tag, -1234567890123LL);
+        pw.add_float(tag, 1.5F);
+        pw.add_double(tag, -2.25);
+        pw.add_bytes(tag, std::string(200, 'x'));
+        pw.add_string(tag, "foo");
+        pw.add_message(tag, std::string{});
+    }
+
+    // Write the same fields as write_dynamic() with tags known at
+    // compile time.
+    template <protozero::pbf_tag_type Tag, typename TBuffer>
+    void write_static(TBuffer& buffer) {
+        protozero::basic_pbf_writer<TBuffer> pw{buffer};
+        pw.template add_bool<Tag>(true);
+        pw.template add_enum<Tag>(-3);
+        pw.template add_int32<Tag>(-17);
+        pw.template add_sint32<Tag>(-17);
+        pw.template add_uint32<Tag>(300);
+        pw.template add_int64<Tag>(std::numeric_limits<int64_t>::min());
+        pw.template add_sint64<Tag>(std::numeric_limits<int64_t>::min());
+        pw.template add_uint64<Tag>(std::numeric_limits<uint64_t>::max());
+        pw.template add_fixed32<Tag>(12345678);
+        pw.template add_sfixed32<Tag>(-12345678);
+        pw.template add_fixed64<Tag>(1234567890123ULL);
+        pw.template add_sfixed64<Tag>(-1234567890123LL);
+        pw.template add_float<Tag>(1.5F);
+        pw.template add_double<Tag>(-2.25);
+        pw.template add_bytes<Tag>(std::string(200, 'x'));
+        pw.template add_string<Tag>("foo");
+        pw.template add_message<Tag>("");
+    }
+
+    template <protozero::pbf_tag_type Tag>
+    void check_static(protozero::pbf_tag_type tag) {
+        std::string expected;
+        write_dynamic(expected, tag);
+
+        std::string buffer;
+        write_static<Tag>(buffer);
+        REQUIRE(buffer == expected);
+
+        std::vector<char> vbuffer;
+        write_static<Tag>(vbuffer);
+        REQUIRE(std::string(vbuffer.data(), vbuffer.size()) == expected);
+    }
+
+} // anonymous namespace
+
+TEST_CASE("Write fields with tags known at compile time") {
+    check_static<1>(1);
+    check_static<15>(15);
+    check_static<16>(16);
+    check_static<2047>(2047);
+    check_static<2048>(2048);
+    check_static<18999>(18999);
+    check_static<20000>(20000);
+    check_static<262143>(262143);
+    check_static<262144>(262144);
+    check_static<33554431>(33554431);
+    check_static<33554432>(33554432);
+    check_static<(1U << 29U) - 1>((1U << 29U) - 1);
+}
+
+TEST_CASE("Write fields with enum tags known at compile time") {
+    std::string expected;
+    {
+        protozero::pbf_builder<Test> pbf{expected};
+        pbf.add_sint32(Test::small, -1);
+        pbf.add_fixed64(Test::medium, 42);
+        pbf.add_string(Test::large, "bar");
+        pbf.add_bool(Test::small, false);
+    }
+
+    std::string buffer;
+    protozero::pbf_builder<Test> pbf{buffer};
+    pbf.add_sint32<Test::small>(-1);
+    pbf.add_fixed64<Test::medium>(42);
+    pbf.add_string<Test::large>("bar");
+    pbf.add_bool<Test::small>(false);
+
+    REQUIRE(buffer == expected);
+
+    protozero::pbf_message<Test> message{buffer};
+    REQUIRE(message.next(Test::small));
+    REQUIRE(message.get_sint32() == -1);
+    REQUIRE(message.next(Test::medium));
+    REQUIRE(message.get_fixed64() == 42);
+    REQUIRE(message.next(Test::large));
+    REQUIRE(message.get_view() == "bar");
+    REQUIRE(message.next(Test::small));
+    REQUIRE_FALSE(message.get_bool());
+    REQUIRE_FALSE(message.next());
+}
+
+TEST_CASE("Write field with tag known at compile time into submessage") {
+    std::string buffer;
+    protozero::pbf_writer pw{buffer};
+    {
+        protozero::pbf_writer sub{pw, 1};
+        sub.add_uint32<2>(17);
+    }
+
+    protozero::pbf_reader reader{buffer};
+    REQUIRE(reader.next(1));
+    auto sub = reader.get_message();
+    REQUIRE(sub.next(2));
+    REQUIRE(sub.get_uint32() == 17);
+    REQUIRE_FALSE(sub.next());
+    REQUIRE_FALSE(reader.next());
+}
@@ -0,0 +1,140 @@
+
+#include <test.hpp>
+
+#include <protozero/buffer_counting.hpp>
+#include <protozero/submessage_sizes.hpp>
+
+#include <array>
+#include <string>
+
+namespace {
+
+    template <typename TWriter>
+    void write_test_message(TWriter& pw) {
+        pw.add_fixed32(1, 42);
+        {
+            TWriter sub{pw, 2};
+            sub.add_string(1, std::string(200, 'x'));
+            {
+                TWriter subsub{sub, 2};
+                subsub.add_sint64(1, -17);
+                const std::array<uint32_t, 4> values = {{1, 300, 70000, 3}};
+                subsub.add_packed_uint32(2, values.begin(), values.end());
+            }
+            {
+                TWriter empty{sub, 3};
+            }
+            {
+                TWriter rolled_back{sub, 4};
+                rolled_back.add_bool(1, true);
+                rolled_back.rollback();
+            }
+            sub.add_int32(5, 123);
+        }
+        {
+            TWriter known_size{pw, 3, 2};
+            known_size.add_bool(1, true);
+        }
+        pw.add_string(4, "foo");
+    }
+
+    std::string expected_test_message() {
+        std::string buffer;
+        protozero::pbf_writer pw{buffer};
+        write_test_message(pw);
+        return buffer;
+    }
+
+} // anonymous namespace
+
+TEST_CASE("Write message in two passes") {
+    protozero::submessage_sizes sizes;
+    REQUIRE(sizes.recording());
+
+    protozero::counting_buffer counter;
+    {
+        protozero::basic_pbf_writer<protozero::counting_buffer> pw{counter, sizes};
+        write_test_message(pw);
+    }
+
+    const std::string expected = expected_test_message();
+    REQUIRE(counter.size() == expected.size());
+    // Packed fields from forward iterators don't need a recorded size.
+    REQUIRE(sizes.size() == 4);
+
+    sizes.start_replay();
+    REQUIRE_FALSE(sizes.recording());
+
+    std::string buffer;
+    buffer.reserve(counter.size());
+    {
+        protozero::pbf_writer pw{buffer, sizes};
+        write_test_message(pw);
+    }
+
+    REQUIRE(buffer == expected);
+
+    SECTION("replay again") {
+        sizes.start_replay();
+        std::string buffer2;
+        protozero::pbf_writer pw{buffer2, sizes};
+        write_test_message(pw);
+        REQUIRE(buffer2 == expected);
+    }
+
+    SECTION("clear and reuse") {
+        sizes.clear();
+        REQUIRE(sizes.recording());
+        REQUIRE(sizes.size() == 0);
+
+        counter.clear();
+        REQUIRE(counter.size() == 0);
+        protozero::basic_pbf_writer<protozero::counting_buffer> pw{counter, sizes};
+        protozero::basic_pbf_writer<protozero::counting_buffer> sub{pw, 1};
+        sub.add_int32(1, 1);
+        sub.commit();
+        REQUIRE(counter.size() == 4);
+        REQUIRE(sizes.size() == 1);
+    }
+}
+
+TEST_CASE("Count size of message with counting buffer") {
+    protozero::counting_buffer counter;
+    protozero::basic_pbf_writer<protozero::counting_buffer> pw{counter};
+    write_test_message(pw);
+
+    REQUIRE(counter.size() == expected_test_message().size());
+}
+
+namespace {
+
+    enum class Test : protozero::pbf_tag_type {
+        sub = 1,
+        value = 2
+    };
+
+    template <typename TBuffer>
+    void write_with_builder(TBuffer& buffer, protozero::submessage_sizes& sizes) {
+        protozero::basic_pbf_builder<TBuffer, Test> pb{buffer, sizes};
+        {
+            protozero::basic_pbf_builder<TBuffer, Test> sub{pb, Test::sub};
+            sub.add_uint64(Test::value, 1000000);
+        }
+        pb.add_uint64(Test::value, 1);
+    }
+
+} // anonymous namespace
+
+TEST_CASE("Write message in two passes with builder") {
+    protozero::submessage_sizes sizes;
+    protozero::counting_buffer counter;
+    write_with_builder(counter, sizes);
+
+    sizes.start_replay();
+    std::string buffer;
+    write_with_builder(buffer, sizes);
+
+    REQUIRE(counter.size() == buffer.size());
+    REQUIRE(buffer == std::string("\x0a\x04\x10\xc0\x84\x3d\x10\x01", 8));
+}
+
@@ -0,0 +1,146 @@
+
+#include <test.hpp>
+
+#include <protozero/validate.hpp>
+
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace {
+
+    enum class Test : protozero::pbf_tag_type {
+        flag     = 1,
+        number   = 2,
+        negative = 3,
+        fixed    = 4,
+        value    = 5,
+        name     = 6,
+        sub      = 7,
+        packed   = 8,
+        large    = 100000
+    };
+
+    std::string create_message() {
+        std::string data;
+        protozero::pbf_builder<Test> pw{data};
+        pw.add_bool(Test::flag, true);
+        pw.add_uint64(Test::number, 0xffffffffffffffffULL);
+        pw.add_sint32(Test::negative, -12345);
+        pw.add_fixed32(Test::fixed, 42);
+        pw.add_double(Test::value, 2.5);
+        pw.add_string(Test::name, "foo");
+        {
+            protozero::pbf_builder<Test> sub{pw, Test::sub};
+            sub.add_uint32(Test::number, 300);
+        }
+        const std::vector<uint32_t> values = {1, 200, 30000, 4000000};
+        pw.add_packed_uint32(Test::packed, values.begin(), values.end());
+        pw.add_int64(Test::large, -1);
+        return data;
+    }
+
+    template <typename TReader>
+    void check_message(TReader reader) {
+        REQUIRE(reader.next(1));
+        REQUIRE(reader.get_bool());
+        REQUIRE(reader.next(2, protozero::pbf_wire_type::varint));
+        REQUIRE(reader.get_uint64() == 0xffffffffffffffffULL);
+        REQUIRE(reader.next());
+        REQUIRE(reader.get_sint32() == -12345);
+        REQUIRE(reader.next());
+        REQUIRE(reader.wire_type() == protozero::pbf_wire_type::fixed32);
+        REQUIRE(reader.get_fixed32() == 42);
+        REQUIRE(reader.next());
+        REQUIRE(reader.get_double() == Approx(2.5));
+        REQUIRE(reader.next());
+        REQUIRE(reader.get_string() == "foo");
+        REQUIRE(reader.next(7));
+        auto sub = reader.get_message();
+        static_assert(std::is_same<decltype(sub), TReader>::value, "get_message() must return same reader type");
+        REQUIRE(sub.next());
+        REQUIRE(sub.get_uint32() == 300);
+        REQUIRE_FALSE(sub.next());
+        REQUIRE(reader.next());
+        const auto packed = reader.get_packed_uint32();
+        const std::vector<uint32_t> values(packed.begin(), packed.end());
+        const std::vector<uint32_t> expected = {1, 200, 30000, 4000000};
+        REQUIRE(values == expected);
+        REQUIRE(reader.next(100000));
+        REQUIRE(reader.get_int64() == -1);
+        REQUIRE_FALSE(reader.next());
+    }
+
+} // anonymous namespace
+
+TEST_CASE("Trusted reader reads the same values as checked reader") {
+    const std::string data = create_message();
+    REQUIRE(protozero::validate(data));
+
+    check_message(protozero::pbf_reader{data});
+    check_message(protozero::trusted_pbf_reader{data});
+}
+
+TEST_CASE("Trusted reader can skip all fields") {
+    const std::string data = create_message();
+
+    int count = 0;
+    protozero::trusted_pbf_reader reader{data};
+    while (reader.next()) {
+        reader.skip();
+        ++count;
+    }
+    REQUIRE(count == 9);
+}
+
+TEST_CASE("Trusted reader reads longest varints") {
+    std::string data;
+    protozero::pbf_writer pw{data};
+    for (int shift = 0; shift < 64; ++shift) {
+        pw.add_uint64(1, 1ULL << static_cast<unsigned int>(shift));
+    }
+
+    protozero::trusted_pbf_reader reader{data};
+    for (int shift = 0; shift < 64; ++shift) {
+        REQUIRE(reader.next());
+        REQUIRE(reader.get_uint64() == 1ULL << static_cast<unsigned int>(shift));
+    }
+    REQUIRE_FALSE(reader.next());
+}
+
+TEST_CASE("Trusted pbf_message") {
+    const std::string data = create_message();
+
+    protozero::pbf_message<Test, protozero::trusted_policy> message{data};
+    REQUIRE(message.next(Test::sub));
+    protozero::pbf_message<Test, protozero::trusted_policy> sub{message.get_message()};
+    REQUIRE(sub.next(Test::number, protozero::pbf_wire_type::varint));
+    REQUIRE(sub.tag() == Test::number);
+    REQUIRE(sub.get_uint32() == 300);
+    REQUIRE(message.next());
+    REQUIRE(message.tag() == Test::packed);
+    message.skip();
+    REQUIRE(message.next(Test::large));
+    REQUIRE(message.get_int64() == -1);
+    REQUIRE_FALSE(message.next());
+}
+
+TEST_CASE("Swap trusted readers") {
+    const std::string data = create_message();
+    protozero::trusted_pbf_reader a{data};
+    protozero::trusted_pbf_reader b;
+    swap(a, b);
+    REQUIRE_FALSE(a);
+    REQUIRE(b.length() == data.size());
+}
+
+TEST_CASE("Trusted reader still checks lengths of packed fixed fields") {
+    std::string data;
+    protozero::pbf_writer pw{data};
+    pw.add_bytes(1, "abc");
+
+    protozero::trusted_pbf_reader reader{data};
+    REQUIRE(reader.next());
+    REQUIRE_THROWS_AS(reader.get_packed_fixed32(), const protozero::invalid_length_exception&);
+}
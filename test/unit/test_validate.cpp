@@ -0,0 +1,260 @@
+
+#include <test.hpp>
+
+#include <protozero/validate.hpp>
+
+#include <cstdint>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+    // Read all fields of a message (but not nested messages) with the
+    // pbf_reader and return the error the validator should report.
+    protozero::validation_error read_message(const std::string& data) {
+        try {
+            protozero::pbf_reader reader{data};
+            while (reader.next()) {
+                reader.skip();
+            }
+        } catch (const protozero::end_of_buffer_exception&) {
+            return protozero::validation_error::end_of_buffer;
+        } catch (const protozero::varint_too_long_exception&) {
+            return protozero::validation_error::varint_too_long;
+        } catch (const protozero::invalid_tag_exception&) {
+            return protozero::validation_error::invalid_tag;
+        } catch (const protozero::unknown_pbf_wire_type_exception&) {
+            return protozero::validation_error::unknown_wire_type;
+        }
+        return protozero::validation_error::none;
+    }
+
+    // Same for the values of a packed repeated varint field.
+    protozero::validation_error read_packed_varint(const std::string& data) {
+        try {
+            const char* p = data.data();
+            const char* const end = p + data.size();
+            while (p != end) {
+                protozero::decode_varint(&p, end);
+            }
+        } catch (const protozero::end_of_buffer_exception&) {
+            return protozero::validation_error::end_of_buffer;
+        } catch (const protozero::varint_too_long_exception&) {
+            return protozero::validation_error::varint_too_long;
+        }
+        return protozero::validation_error::none;
+    }
+
+    // Create something looking like a vector tile.
+    std::string create_tile() {
+        std::string data;
+        protozero::pbf_writer tile{data};
+        for (int l = 0; l < 3; ++l) {
+            protozero::pbf_writer layer{tile, 3};
+            layer.add_uint32(15, 2);
+            layer.add_string(1, "layer");
+            for (uint32_t f = 0; f < 20; ++f) {
+                protozero::pbf_writer feature{layer, 2};
+                feature.add_uint64(1, f * 1000);
+                const std::vector<uint32_t> tags = {0, f, 1, f + 1};
+                feature.add_packed_uint32(2, tags.begin(), tags.end());
+                feature.add_enum(3, 1);
+                const std::vector<uint32_t> geometry = {9, f * 50, f * 70 + 1000};
+                feature.add_packed_uint32(4, geometry.begin(), geometry.end());
+            }
+            layer.add_string(3, "key");
+            for (int v = 0; v < 5; ++v) {
+                protozero::pbf_writer value{layer, 4};
+                value.add_double(3, v * 1.5);
+                value.add_sint64(6, -v);
+            }
+            layer.add_uint32(5, 4096);
+        }
+        return data;
+    }
+
+    bool is_tile_message(const protozero::pbf_tag_type* path, std::size_t depth) {
+        // layers (3) contain features (2) and values (4)
+        return path[0] == 3 && (depth == 1 || (depth == 2 && (path[1] == 2 || path[1] == 4)));
+    }
+
+} // anonymous namespace
+
+TEST_CASE("Validate empty message") {
+    const auto result = protozero::validate(protozero::data_view{});
+    REQUIRE(result);
+    REQUIRE(result.ok());
+    REQUIRE(result.error() == protozero::validation_error::none);
+    REQUIRE(result.offset() == 0);
+}
+
+TEST_CASE("Validate valid message") {
+    std::string data;
+    protozero::pbf_writer pw{data};
+    pw.add_uint64(1, 1234567890123ULL);
+    pw.add_double(2, 1.5);
+    pw.add_string(3, "foo");
+    pw.add_fixed32(4, 17);
+    REQUIRE(protozero::validate(data));
+}
+
+TEST_CASE("Validate invalid messages") {
+    SECTION("truncated varint") {
+        const auto result = protozero::validate(std::string{"\x08\x01\x08\x80", 4});
+        REQUIRE(result.error() == protozero::validation_error::end_of_buffer);
+        REQUIRE(result.offset() == 2);
+    }
+
+    SECTION("varint too long") {
+        const auto result = protozero::validate(std::string{"\x08\x80\x80\x80\x80\x80\x80\x80\x80\x80\x80\x01"});
+        REQUIRE(result.error() == protozero::validation_error::varint_too_long);
+        REQUIRE(result.offset() == 0);
+    }
+
+    SECTION("tag 0") {
+        const auto result = protozero::validate(std::string{"\x08\x01\x00\x01", 4});
+        REQUIRE(result.error() == protozero::validation_error::invalid_tag);
+        REQUIRE(result.offset() == 2);
+    }
+
+    SECTION("reserved tag") {
+        std::string data;
+        protozero::write_varint(std::back_inserter(data), 19000U << 3U);
+        data += '\x01';
+        REQUIRE(protozero::validate(data).error() == protozero::validation_error::invalid_tag);
+    }
+
+    SECTION("unknown wire type") {
+        const auto result = protozero::validate(std::string{"\x0b\x01"});
+        REQUIRE(result.error() == protozero::validation_error::unknown_wire_type);
+    }
+
+    SECTION("truncated fixed64") {
+        const auto result = protozero::validate(std::string{"\x09\x01\x02\x03\x04\x05\x06\x07"});
+        REQUIRE(result.error() == protozero::validation_error::end_of_buffer);
+    }
+
+    SECTION("length too large") {
+        const auto result = protozero::validate(std::string{"\x0a\x03\x61\x62"});
+        REQUIRE(result.error() == protozero::validation_error::end_of_buffer);
+    }
+}
+
+TEST_CASE("Validate nested messages") {
+    std::string data;
+    {
+        protozero::pbf_writer pw{data};
+        pw.add_string(1, "not a message");
+        protozero::pbf_writer sub{pw, 2};
+        sub.add_uint32(1, 17);
+        protozero::pbf_writer subsub{sub, 2};
+        subsub.add_string(1, "\xff");
+    }
+
+    const auto all = [](const protozero::pbf_tag_type* path, std::size_t depth) {
+        return path[0] == 2 && depth < 3;
+    };
+
+    REQUIRE(protozero::validate(data));
+    REQUIRE(protozero::validate(data, 2, all));
+
+    const auto result = protozero::validate(data, 1, all);
+    REQUIRE(result.error() == protozero::validation_error::too_deep);
+    REQUIRE(result.offset() == 19);
+
+    // Treating the string in the innermost message as a message fails.
+    const auto inner = protozero::validate(data, 3, [](const protozero::pbf_tag_type* path, std::size_t /*depth*/) {
+        return path[0] == 2;
+    });
+    REQUIRE(inner.error() == protozero::validation_error::end_of_buffer);
+    REQUIRE(inner.offset() == 23);
+
+    std::vector<std::vector<protozero::pbf_tag_type>> paths;
+    protozero::validate(data, 5, [&](const protozero::pbf_tag_type* path, std::size_t depth) {
+        paths.emplace_back(path, path + depth);
+        return path[0] == 2 && depth < 3;
+    });
+    const std::vector<std::vector<protozero::pbf_tag_type>> expected = {{1}, {2}, {2, 2}, {2, 2, 1}};
+    REQUIRE(paths == expected);
+}
+
+TEST_CASE("Validate vector tile") {
+    const std::string data = create_tile();
+    REQUIRE(protozero::validate(data));
+    REQUIRE(protozero::validate(data, 2, is_tile_message));
+
+    const auto result = protozero::validate(data, 1, is_tile_message);
+    REQUIRE(result.error() == protozero::validation_error::too_deep);
+}
+
+TEST_CASE("Validation agrees with pbf_reader on corrupted data") {
+    const std::string data = create_tile();
+    std::mt19937 rng{17};
+    std::uniform_int_distribution<std::size_t> pos{0, 200};
+    std::uniform_int_distribution<int> byte{0, 255};
+
+    // Corrupt the beginning of a layer which contains fields of all types.
+    protozero::pbf_reader tile{data};
+    REQUIRE(tile.next(3));
+    const auto layer = tile.get_view();
+    const std::string original{layer.data(), 300};
+
+    int invalid = 0;
+    for (int i = 0; i < 2000; ++i) {
+        std::string message = original;
+        for (int n = 0; n < 3; ++n) {
+            message[pos(rng)] = static_cast<char>(byte(rng));
+        }
+        const auto result = protozero::validate(message);
+        REQUIRE(result.error() == read_message(message));
+        if (!result) {
+            ++invalid;
+        }
+    }
+    REQUIRE(invalid > 0);
+}
+
+TEST_CASE("Validate packed varint") {
+    REQUIRE(protozero::validate_packed_varint(protozero::data_view{}));
+
+    SECTION("valid") {
+        std::string data;
+        protozero::pbf_writer pw{data};
+        const std::vector<uint64_t> values = {0, 1, 127, 128, 300, 0xffffffffULL, 0xffffffffffffffffULL};
+        pw.add_packed_uint64(1, values.begin(), values.end());
+
+        protozero::pbf_reader reader{data};
+        REQUIRE(reader.next());
+        REQUIRE(protozero::validate_packed_varint(reader.get_view()));
+    }
+
+    SECTION("truncated") {
+        const std::string data(40, '\x80');
+        const auto result = protozero::validate_packed_varint(data.substr(0, 5));
+        REQUIRE(result.error() == protozero::validation_error::end_of_buffer);
+        REQUIRE(result.offset() == 0);
+    }
+
+    SECTION("too long") {
+        std::string data(50, '\x01');
+        data.replace(37, 10, 10, '\x80');
+        const auto result = protozero::validate_packed_varint(data);
+        REQUIRE(result.error() == protozero::validation_error::varint_too_long);
+        REQUIRE(result.offset() == 37);
+    }
+
+    SECTION("agrees with decode_varint") {
+        std::mt19937 rng{42};
+        std::uniform_int_distribution<std::size_t> size{0, 100};
+        std::bernoulli_distribution continuation{0.85};
+        for (int i = 0; i < 5000; ++i) {
+            std::string data(size(rng), '\0');
+            for (auto& c : data) {
+                c = static_cast<char>(continuation(rng) ? 0x81 : 0x01);
+            }
+            REQUIRE(protozero::validate_packed_varint(data).error() == read_packed_varint(data));
+        }
+    }
+}
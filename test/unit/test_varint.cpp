@@ -1,6 +1,9 @@
 
 #include <test.hpp>
 
+#include <algorithm>
+#include <iterator>
+
 TEST_CASE("max varint length") {
     REQUIRE(protozero::max_varint_length == 10);
 }
@@ -239,3 +242,34 @@ TEST_CASE("check lengths of varint") {
     REQUIRE(protozero::length_of_varint(0xffffffffffffffffULL) == 10);
 }
 
+TEST_CASE("decode varints of all lengths followed by more data") {
+    // Enough data after each varint so the fast path is always taken. The
+    // bytes after the varint all have the continuation bit set.
+    char buffer[protozero::max_varint_length * 2];
+
+    for (uint32_t i = 0; i < 64; ++i) {
+        for (const uint64_t n : {(1ULL << i) - 1, 1ULL << i, (1ULL << i) | 1ULL, ~0ULL >> i}) {
+            std::fill(std::begin(buffer), std::end(buffer), static_cast<char>(0xff));
+            const auto length = protozero::write_varint(buffer, n);
+            REQUIRE(length == protozero::length_of_varint(n));
+
+            const char* b = buffer;
+            REQUIRE(protozero::decode_varint(&b, std::end(buffer)) == n);
+            REQUIRE(b == buffer + length);
+        }
+    }
+}
+
+TEST_CASE("decode non-canonical padded varints") {
+    const char buffer[] = "\x81\x80\x80\x80\x00\x80\x80\x80\x80\x80\x80\x80\x80\x00\x01\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff";
+    const char* end = buffer + sizeof(buffer) - 1;
+    const char* b = buffer;
+    REQUIRE(protozero::decode_varint(&b, end) == 1);
+    REQUIRE(b == buffer + 5);
+    REQUIRE(protozero::decode_varint(&b, end) == 0);
+    REQUIRE(b == buffer + 14);
+    REQUIRE(protozero::decode_varint(&b, end) == 1);
+    REQUIRE(b == buffer + 15);
+    REQUIRE_THROWS_AS(protozero::decode_varint(&b, end), const protozero::varint_too_long_exception&);
+    REQUIRE(b == buffer + 15);
+}
@@ -0,0 +1,176 @@
+
+#include <test.hpp>
+
+#include <protozero/vector_tile_geometry.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace {
+
+    uint32_t command(protozero::geometry_command cmd, uint32_t count) {
+        return (count << 3U) | static_cast<uint32_t>(cmd);
+    }
+
+    uint32_t param(int32_t value) {
+        return protozero::encode_zigzag32(value);
+    }
+
+    // Records all calls as a string.
+    struct recording_handler {
+        std::string calls;
+
+        void add_points(const char* name, const protozero::geometry_point* points, std::size_t count) {
+            calls += name;
+            for (std::size_t n = 0; n < count; ++n) {
+                calls += ' ' + std::to_string(points[n].x) + ',' + std::to_string(points[n].y);
+            }
+            calls += ';';
+        }
+
+        void move_to(const protozero::geometry_point* points, std::size_t count) {
+            add_points("M", points, count);
+        }
+
+        void line_to(const protozero::geometry_point* points, std::size_t count) {
+            add_points("L", points, count);
+        }
+
+        void close_path() {
+            calls += "Z;";
+        }
+    };
+
+    // Encode the values as packed uint32 field and decode them with the
+    // decoder using the handler.
+    std::string decode_with_handler(protozero::geometry_decoder& decoder, const std::vector<uint32_t>& values) {
+        std::string buffer;
+        protozero::pbf_writer pw{buffer};
+        pw.add_packed_uint32(4, values.begin(), values.end());
+
+        protozero::pbf_reader feature{buffer};
+        recording_handler handler;
+        if (feature.next(4)) {
+            decoder.decode(feature.get_packed_uint32(), handler);
+        }
+        return handler.calls;
+    }
+
+} // anonymous namespace
+
+using cmd = protozero::geometry_command;
+
+TEST_CASE("decode point geometry") {
+    protozero::geometry_decoder decoder;
+    const std::vector<uint32_t> values{command(cmd::move_to, 1), param(25), param(17)};
+    REQUIRE(decode_with_handler(decoder, values) == "M 25,17;");
+}
+
+TEST_CASE("decode multipoint geometry") {
+    protozero::geometry_decoder decoder;
+    const std::vector<uint32_t> values{command(cmd::move_to, 2), param(5), param(7), param(-2), param(3)};
+    REQUIRE(decode_with_handler(decoder, values) == "M 5,7 3,10;");
+}
+
+TEST_CASE("decode multilinestring geometry") {
+    protozero::geometry_decoder decoder;
+    const std::vector<uint32_t> values{
+        command(cmd::move_to, 1), param(2), param(2),
+        command(cmd::line_to, 2), param(0), param(8), param(8), param(0),
+        command(cmd::move_to, 1), param(-10), param(-10),
+        command(cmd::line_to, 1), param(-1), param(1)
+    };
+    REQUIRE(decode_with_handler(decoder, values) == "M 2,2;L 2,10 10,10;M 0,0;L -1,1;");
+
+    // Use the same decoder again, the cursor starts at 0,0 again.
+    REQUIRE(decode_with_handler(decoder, values) == "M 2,2;L 2,10 10,10;M 0,0;L -1,1;");
+}
+
+TEST_CASE("decode polygon geometry into buffer") {
+    const std::vector<uint32_t> values{
+        command(cmd::move_to, 1), param(3), param(6),
+        command(cmd::line_to, 2), param(5), param(6), param(12), param(22),
+        command(cmd::close_path, 1),
+        command(cmd::move_to, 1), param(1), param(1),
+        command(cmd::line_to, 3), param(1), param(0), param(0), param(1), param(-1), param(0),
+        command(cmd::close_path, 1)
+    };
+
+    std::string buffer;
+    protozero::pbf_writer pw{buffer};
+    pw.add_packed_uint32(4, values.begin(), values.end());
+
+    protozero::geometry_decoder decoder;
+    recording_handler handler;
+    protozero::pbf_reader feature{buffer};
+    REQUIRE(feature.next(4));
+    const auto range = feature.get_packed_uint32();
+    decoder.decode(range, handler);
+    REQUIRE(handler.calls == "M 3,6;L 8,12 20,34;Z;M 21,35;L 22,35 22,36 21,36;Z;");
+
+    std::vector<protozero::geometry_point> points{{1, 1}};
+    std::vector<std::size_t> part_starts{5};
+    decoder.decode(range, points, part_starts);
+
+    const std::vector<protozero::geometry_point> expected_points{
+        {3, 6}, {8, 12}, {20, 34}, {21, 35}, {22, 35}, {22, 36}, {21, 36}
+    };
+    const std::vector<std::size_t> expected_starts{0, 3};
+    REQUIRE(points == expected_points);
+    REQUIRE(part_starts == expected_starts);
+}
+
+TEST_CASE("decode empty geometry") {
+    protozero::geometry_decoder decoder;
+    REQUIRE(decode_with_handler(decoder, {}).empty());
+}
+
+TEST_CASE("decode invalid geometries") {
+    protozero::geometry_decoder decoder;
+
+    const std::vector<uint32_t> unknown_command{command(static_cast<cmd>(3), 1), param(1), param(1)};
+    REQUIRE_THROWS_AS(decode_with_handler(decoder, unknown_command),
+                      const protozero::invalid_geometry_exception&);
+
+    const std::vector<uint32_t> move_to_without_points{command(cmd::move_to, 0)};
+    REQUIRE_THROWS_AS(decode_with_handler(decoder, move_to_without_points),
+                      const protozero::invalid_geometry_exception&);
+
+    const std::vector<uint32_t> missing_parameter{command(cmd::move_to, 2), param(1), param(1), param(1)};
+    REQUIRE_THROWS_AS(decode_with_handler(decoder, missing_parameter),
+                      const protozero::invalid_geometry_exception&);
+
+    const std::vector<uint32_t> close_path_count{command(cmd::move_to, 1), param(1), param(1), command(cmd::close_path, 2)};
+    REQUIRE_THROWS_AS(decode_with_handler(decoder, close_path_count),
+                      const protozero::invalid_geometry_exception&);
+}
+
+TEST_CASE("decode geometry must start with MoveTo") {
+    protozero::geometry_decoder decoder;
+
+    const std::vector<uint32_t> line_to{command(cmd::line_to, 1), param(1), param(1)};
+    const std::vector<uint32_t> close_path{command(cmd::close_path, 1),
+                                           command(cmd::move_to, 1), param(1), param(1)};
+
+    for (const auto& values : {line_to, close_path}) {
+        std::string buffer;
+        protozero::pbf_writer pw{buffer};
+        pw.add_packed_uint32(4, values.begin(), values.end());
+
+        protozero::pbf_reader feature{buffer};
+        REQUIRE(feature.next(4));
+        const auto geometry = feature.get_packed_uint32();
+
+        std::vector<protozero::geometry_point> points;
+        std::vector<std::size_t> part_starts;
+        REQUIRE_THROWS_AS(decoder.decode(geometry, points, part_starts),
+                          const protozero::invalid_geometry_exception&);
+
+        recording_handler handler;
+        REQUIRE_THROWS_AS(decoder.decode(geometry, handler),
+                          const protozero::invalid_geometry_exception&);
+        REQUIRE(handler.calls.empty());
+    }
+}
@@ -11,7 +11,8 @@ Usage:
 
     pbf-decoder [OPTIONS] [FILENAME]
 
-Use "-" as a file name to read from STDIN.
+Use "-" as a file name to read from STDIN. Files are memory mapped, so
+even very large files are not copied into memory.
 
 The output always goes to STDOUT.
 
@@ -19,167 +20,196 @@ Call with --help/-h to see more options.
 
 *****************************************************************************/
 
+#include <protozero/mapped_file.hpp>
 #include <protozero/pbf_reader.hpp>
+#include <protozero/validate.hpp>
 
 #include <algorithm>
 #include <cctype>
+#include <cinttypes>
 #include <cstddef>
+#include <cstdint>
+#include <cstdio>
 #include <exception>
-#include <fstream>
 #include <getopt.h>
 #include <iostream>
 #include <limits>
-#include <sstream>
 #include <stdexcept>
 #include <string>
+#include <vector>
+
+namespace {
+
+// Throw the exception the pbf_reader would have thrown.
+[[noreturn]] void throw_validation_error(protozero::validation_error error) {
+    switch (error) {
+        case protozero::validation_error::varint_too_long:
+            throw protozero::varint_too_long_exception{};
+        case protozero::validation_error::invalid_tag:
+            throw protozero::invalid_tag_exception{};
+        case protozero::validation_error::unknown_wire_type:
+            throw protozero::unknown_pbf_wire_type_exception{};
+        default:
+            break;
+    }
+    throw protozero::end_of_buffer_exception{};
+}
 
-std::string decode(const char* data, std::size_t len, const std::string& indent);
+// Output formatting the same as for std::ostream with default settings.
+void append_number(std::string& out, int64_t value) {
+    char buffer[32];
+    const int len = std::snprintf(buffer, sizeof(buffer), "%" PRId64, value);
+    out.append(buffer, static_cast<std::size_t>(len));
+}
 
-// Try decoding as a nested message
-bool decode_message(std::stringstream& out, const std::string& indent, const protozero::data_view view) {
-    try {
-        const auto nested = decode(view.data(), view.size(), indent + "  ");
-        out << '\n' << nested;
-        return true;
-    } catch (const protozero::exception&) {
+void append_number(std::string& out, double value) {
+    char buffer[64];
+    const int len = std::snprintf(buffer, sizeof(buffer), "%g", value);
+    out.append(buffer, static_cast<std::size_t>(len));
+}
+
+// Append a list of numbers from a range
+template <typename TIterator>
+void append_number_range(std::string& out, TIterator it, TIterator end) {
+    bool first = true;
+    for (; it != end; ++it) {
+        if (first) {
+            first = false;
+        } else {
+            out += ',';
+        }
+        append_number(out, *it);
     }
-    return false;
+    out += '\n';
 }
 
-// Try decoding as a string (only printable characters allowed).
-bool decode_printable_string(std::stringstream& out, const protozero::data_view view) {
-    static constexpr const std::size_t max_string_length = 60;
+bool is_printable(char c) noexcept {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+           c == '_' || c == ':' || c == '-';
+}
 
-    const std::string str{view.data(), view.size()};
-    if (str.find_first_not_of("abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_:-") != std::string::npos) {
+constexpr const std::size_t max_string_length = 60;
+
+// Try decoding as a string (only printable characters allowed).
+bool decode_printable_string(std::string& out, const protozero::data_view view) {
+    if (!std::all_of(view.data(), view.data() + view.size(), is_printable)) {
         return false;
     }
 
-    if (str.size() > max_string_length) {
-        out << '"' << str.substr(0, max_string_length) << "\"...\n";
+    out += '"';
+    if (view.size() > max_string_length) {
+        out.append(view.data(), max_string_length);
+        out += "\"...\n";
     } else {
-        out << '"' << str << '"' << '\n';
+        out.append(view.data(), view.size());
+        out += "\"\n";
     }
     return true;
 }
 
-// Try decoding as a string.
-bool decode_string(std::stringstream& out, const protozero::data_view view) {
-    static constexpr const std::size_t max_string_length = 60;
-
-    std::string str{view.data(), std::min(view.size(), max_string_length)};
-    out << '"';
-
-    for (const auto c : str) {
-        if (std::isprint(c) != 0) {
-            out << c;
-        } else {
-            out << '.';
-        }
+// Decode as a string.
+void decode_string(std::string& out, const protozero::data_view view) {
+    out += '"';
+    const std::size_t size = std::min(view.size(), max_string_length);
+    for (std::size_t i = 0; i < size; ++i) {
+        const char c = view.data()[i];
+        out += std::isprint(static_cast<unsigned char>(c)) != 0 ? c : '.';
     }
+    out += "\"\n";
+}
 
-    out << '"' << '\n';
+// Decode something that is not a message: a string, bytes, or packed
+// repeated field.
+void decode_non_message(std::string& out, const protozero::data_view view) {
+    const char* const begin = view.data();
+    const char* const end = begin + view.size();
 
-    return true;
-}
+    if (decode_printable_string(out, view)) {
+        return;
+    }
 
-// Print a list of numbers from a range
-template <typename TRange>
-void print_number_range(std::stringstream& out, const TRange& range) {
-    bool first = true;
-    for (auto val : range) {
-        if (first) {
-            first = false;
-        } else {
-            out << ',';
-        }
-        out << val;
+    if (view.size() % 8 == 0) {
+        append_number_range(out, protozero::const_fixed_iterator<double>{begin},
+                                 protozero::const_fixed_iterator<double>{end});
+        return;
     }
-    out << '\n';
-}
 
-// Try decoding as packed repeated double
-bool decode_packed_double(std::stringstream& out, std::size_t size, protozero::pbf_reader& message) {
-    if (size % 8 != 0) {
-        return false;
+    if (view.size() % 4 == 0) {
+        append_number_range(out, protozero::const_fixed_iterator<float>{begin},
+                                 protozero::const_fixed_iterator<float>{end});
+        return;
     }
-    try {
-        print_number_range(out, message.get_packed_double());
-        return true;
-    } catch (const protozero::exception&) {
+
+    if (protozero::validate_packed_varint(view)) {
+        append_number_range(out, protozero::const_varint_iterator<int64_t>{begin, end},
+                                 protozero::const_varint_iterator<int64_t>{end, end});
+        return;
     }
 
-    return false;
+    decode_string(out, view);
 }
 
-// Try decoding as packed repeated float
-bool decode_packed_float(std::stringstream& out, std::size_t size, protozero::pbf_reader& message) {
-    if (size % 4 != 0) {
-        return false;
-    }
-    try {
-        print_number_range(out, message.get_packed_float());
-        return true;
-    } catch (const protozero::exception&) {
+} // anonymous namespace
+
+// Decode message and append the result to out. Nested messages are kept on
+// an explicit stack instead of recursing. All data is checked before it is
+// read, so the pbf_readers on the stack never throw.
+void decode(std::string& out, const protozero::data_view data) {
+    const auto result = protozero::validate(data);
+    if (!result) {
+        throw_validation_error(result.error());
     }
 
-    return false;
-}
+    std::vector<protozero::pbf_reader> stack;
+    stack.emplace_back(data);
 
-// Try decoding as packed repeated varint
-bool decode_packed_varint(std::stringstream& out, protozero::pbf_reader& message) {
-    try {
-        print_number_range(out, message.get_packed_int64());
-        return true;
-    } catch (const protozero::exception&) {
-    }
+    while (!stack.empty()) {
+        protozero::pbf_reader& message = stack.back();
+        if (!message.next()) {
+            stack.pop_back();
+            continue;
+        }
 
-    return false;
-}
+        out.append(2 * (stack.size() - 1), ' ');
+        append_number(out, static_cast<int64_t>(message.tag()));
+        out += ": ";
 
-std::string decode(const char* data, std::size_t len, const std::string& indent) {
-    std::stringstream stream;
-    protozero::pbf_reader message{data, len};
-    while (message.next()) {
-        stream << indent << message.tag() << ": ";
         switch (message.wire_type()) {
-            case protozero::pbf_wire_type::varint: {
+            case protozero::pbf_wire_type::varint:
                 // This is int32, int64, uint32, uint64, sint32, sint64, bool, or enum.
                 // Try decoding as int64.
-                stream << message.get_int64() << '\n';
+                append_number(out, message.get_int64());
+                out += '\n';
                 break;
-            }
             case protozero::pbf_wire_type::fixed64:
                 // This is fixed64, sfixed64, or double.
                 // Try decoding as a double, because int64_t or uint64_t
                 // would probably be encoded as varint.
-                stream << message.get_double() << '\n';
+                append_number(out, message.get_double());
+                out += '\n';
                 break;
             case protozero::pbf_wire_type::length_delimited: {
                 // This is string, bytes, embedded messages, or packed repeated fields.
-                protozero::pbf_reader message_copy{message};
                 const auto view = message.get_view();
-
-                decode_message(stream, indent, view) ||
-                    decode_printable_string(stream, view) ||
-                    decode_packed_double(stream, view.size(), message_copy) ||
-                    decode_packed_float(stream, view.size(), message_copy) ||
-                    decode_packed_varint(stream, message_copy) ||
-                    decode_string(stream, view);
+                if (protozero::validate(view)) {
+                    out += '\n';
+                    stack.emplace_back(view); // invalidates message
+                } else {
+                    decode_non_message(out, view);
+                }
                 break;
             }
             case protozero::pbf_wire_type::fixed32:
                 // This is fixed32, sfixed32, or float.
                 // Try decoding as a float, because int32_t or uint32_t
                 // would probably be encoded as varint.
-                stream << message.get_float() << '\n';
+                append_number(out, static_cast<double>(message.get_float()));
+                out += '\n';
                 break;
             default:
-                throw protozero::unknown_pbf_wire_type_exception{};
+                break; // can't happen, checked in validate()
         }
     }
-
-    return stream.str();
 }
 
 void print_help() {
@@ -192,12 +222,6 @@ void print_help() {
               << "  -o, --offset=OFFSET  Start reading from OFFSET bytes\n";
 }
 
-std::string read_from_file(const char* filename) {
-    std::ifstream file{filename, std::ios::binary};
-    return std::string{std::istreambuf_iterator<char>(file.rdbuf()),
-                       std::istreambuf_iterator<char>()};
-}
-
 std::string read_from_stdin() {
     return std::string{std::istreambuf_iterator<char>(std::cin.rdbuf()),
                        std::istreambuf_iterator<char>()};
@@ -247,22 +271,25 @@ int main(int argc, char* argv[]) {
     const std::string filename{argv[optind]};
 
     try {
-        std::string buffer{filename == "-" ? read_from_stdin() :
-                                             read_from_file(argv[optind])};
-
-        if (offset > buffer.size()) {
-            throw std::runtime_error{"offset is larger than file size"};
-        }
-
-        if (offset > 0) {
-            buffer.erase(0, offset);
+        // Data from STDIN has to be read into memory, files are mapped.
+        std::string buffer;
+        protozero::mapped_file file;
+        protozero::data_view data;
+        if (filename == "-") {
+            buffer = read_from_stdin();
+            data = protozero::data_view{buffer.data(), buffer.size()};
+        } else {
+            file = protozero::mapped_file{filename};
+            data = file.view();
         }
 
-        if (length < buffer.size()) {
-            buffer.resize(length);
+        if (offset > data.size()) {
+            throw std::runtime_error{"offset is larger than file size"};
         }
 
-        std::cout << decode(buffer.data(), buffer.size(), "");
+        std::string out;
+        decode(out, protozero::data_view{data.data() + offset, std::min(length, data.size() - offset)});
+        std::cout.write(out.data(), static_cast<std::streamsize>(out.size()));
     } catch (const std::exception& ex) {
         std::cerr << ex.what() << '\n';
         return 1;